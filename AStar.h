@@ -1,6 +1,8 @@
 #ifndef COMMON_ASTAR_H
 #define COMMON_ASTAR_H
 
+#include <cassert>
+#include <climits>
 #include <iostream>
 #include <map>
 #include <queue>
@@ -10,6 +12,15 @@
 
 namespace Common {
 
+template<typename T>
+class CompFunc {
+	public:
+		bool operator()(const std::pair<int, const T&>& lhs, const std::pair<int, const T&>& rhs)
+		{
+			return lhs.first > rhs.first;
+		}
+};
+
 template<typename T>
 class AStar {
 	private:
@@ -22,15 +33,61 @@ class AStar {
 	public:
 		static inline std::list<T> solve(GraphFunc g, CostFunc c, HeurFunc h, 
 			GoalTestFunc gtfunc, const T& start);
-};
 
-template<typename T>
-class CompFunc {
-	public:
-		bool operator()(const std::pair<int, const T&>& lhs, const std::pair<int, const T&>& rhs)
-		{
-			return lhs.first > rhs.first;
-		}
+		enum class Status {
+			Found,
+			Unreachable,
+			// the limits stopped the search before a path was known to be
+			// the shortest: the path leads to the node that looked closest
+			// to the goal, or for searchBidirectional() it may also be a
+			// whole path that isn't the shortest
+			LimitReached
+		};
+		// bounds for search() and searchBidirectional()
+		struct Limits {
+			Limits(int maxCost_ = INT_MAX, unsigned int maxExpansions_ = UINT_MAX)
+				: maxCost(maxCost_), maxExpansions(maxExpansions_) { }
+			int maxCost; // nodes whose f cost is higher are not searched
+			unsigned int maxExpansions;
+		};
+
+		// The same search with the callbacks as template parameters so that
+		// they can be inlined. Instead of returning a set, the graph writes
+		// the neighbours of a node to out and returns their number, which
+		// may be at most MaxNeighbours:
+		// unsigned int g(const T& a, T* out)
+		// If the limits stop the search, the path to the expanded node with
+		// the lowest heuristic is returned instead.
+		template<unsigned int MaxNeighbours = 8, typename Graph, typename Cost,
+			typename Heur, typename GoalTest>
+		static inline std::list<T> search(Graph g, Cost c, Heur h,
+			GoalTest gtfunc, const T& start, const Limits& limits = Limits(),
+			Status* status = nullptr);
+
+		// Searches from both ends at once, which needs the graph to be
+		// undirected and both heuristics to be consistent: h estimates the
+		// cost to goal and rh the cost from start. Found is only reported
+		// for the shortest path, as with search().
+		template<unsigned int MaxNeighbours = 8, typename Graph, typename Cost,
+			typename Heur, typename ReverseHeur>
+		static inline std::list<T> searchBidirectional(Graph g, Cost c, Heur h,
+			ReverseHeur rh, const T& start, const T& goal, const Limits& limits = Limits(),
+			Status* status = nullptr);
+
+	private:
+		struct SearchNode {
+			int g; // real cost
+			bool closed;
+			bool hasParent;
+			T parent;
+		};
+		typedef std::map<T, SearchNode> SearchNodes;
+		typedef std::priority_queue<std::pair<int, T>, std::vector<std::pair<int, T> >, CompFunc<T>> OpenList;
+		// prepends the path from the start of the search to node
+		static inline void tracePath(const SearchNodes& nodes, const T& node, std::list<T>& path);
+		// adds child to the open list if this is a shorter way to it
+		static inline bool relax(SearchNodes& nodes, OpenList& open_nodes, const T& parent,
+			int g_cost, int f_cost, const T& child);
 };
 
 template<typename T>
@@ -112,6 +169,253 @@ std::list<T> AStar<T>::solve(GraphFunc g, CostFunc c, HeurFunc h,
 	return path;
 }
 
+template<typename T>
+template<unsigned int MaxNeighbours, typename Graph, typename Cost, typename Heur, typename GoalTest>
+std::list<T> AStar<T>::search(Graph g, Cost c, Heur h,
+		GoalTest gtfunc, const T& start, const Limits& limits, Status* status)
+{
+	using namespace std;
+
+	// the visited flag, cost and parent in one lookup
+	SearchNodes nodes;
+	list<T> path;
+	OpenList open_nodes; // key is the total (f) cost
+	T children[MaxNeighbours];
+	unsigned int expansions = 0;
+	bool limited = false;
+
+	// the best effort if the limits are hit
+	T best = start;
+	int best_h = h(start);
+
+	SearchNode startNode = { 0, false, false, start };
+	nodes.insert(make_pair(start, startNode));
+	open_nodes.push(make_pair(0, start));
+	do {
+		T current(open_nodes.top().second);
+		open_nodes.pop();
+
+		// previous entries of relaxed nodes are left in the queue
+		typename SearchNodes::iterator current_it = nodes.find(current);
+		if(current_it->second.closed)
+			continue;
+
+		if(gtfunc(current)) {
+			path.push_front(current);
+			break;
+		}
+
+		if(expansions == limits.maxExpansions) {
+			limited = true;
+			break;
+		}
+		current_it->second.closed = true;
+		expansions++;
+
+		if(limits.maxCost != INT_MAX || limits.maxExpansions != UINT_MAX) {
+			int this_h = h(current);
+			if(this_h < best_h) {
+				best = current;
+				best_h = this_h;
+			}
+		}
+
+		unsigned int num_children = g(current, children);
+		assert(num_children <= MaxNeighbours);
+		for(unsigned int i = 0; i < num_children; i++) {
+			const T& child = children[i];
+			typename SearchNodes::iterator child_it = nodes.find(child);
+			if(child_it != nodes.end() && child_it->second.closed)
+				continue;
+
+			int edge_cost = c(current, child);
+			if(edge_cost < 0) {
+				fprintf(stderr, "A* error: negative edge cost\n");
+				continue;
+			}
+			int this_g_cost = current_it->second.g + edge_cost;
+			int this_f_cost = this_g_cost + h(child);
+			if(this_f_cost > limits.maxCost) {
+				limited = true;
+				continue;
+			}
+			relax(nodes, open_nodes, current, this_g_cost, this_f_cost, child);
+		}
+	} while(!open_nodes.empty());
+
+	if(!path.empty()) {
+		if(status)
+			*status = Status::Found;
+	} else if(limited) {
+		path.push_front(best);
+		if(status)
+			*status = Status::LimitReached;
+	} else {
+		if(status)
+			*status = Status::Unreachable;
+		return path;
+	}
+	tracePath(nodes, path.front(), path);
+#ifdef DEBUG_ASTAR
+	printPath(path);
+#endif
+	return path;
+}
+
+template<typename T>
+template<unsigned int MaxNeighbours, typename Graph, typename Cost, typename Heur, typename ReverseHeur>
+std::list<T> AStar<T>::searchBidirectional(Graph g, Cost c, Heur h,
+		ReverseHeur rh, const T& start, const T& goal, const Limits& limits, Status* status)
+{
+	using namespace std;
+
+	// forwards from start and backwards from goal
+	SearchNodes nodes[2];
+	OpenList open_nodes[2];
+	list<T> path;
+	T children[MaxNeighbours];
+	unsigned int expansions = 0;
+	bool limited = false;
+	// stopped while a cheaper path could still be found
+	bool unproven = false;
+
+	// the cheapest path through a node reached from both sides so far
+	int best_cost = INT_MAX;
+	T meeting = start;
+
+	// the best effort if the limits are hit
+	T best = start;
+	int best_h = h(start);
+
+	SearchNode startNode = { 0, false, false, start };
+	SearchNode goalNode = { 0, false, false, goal };
+	nodes[0].insert(make_pair(start, startNode));
+	nodes[1].insert(make_pair(goal, goalNode));
+	open_nodes[0].push(make_pair(0, start));
+	open_nodes[1].push(make_pair(0, goal));
+	if(!(start < goal) && !(goal < start))
+		best_cost = 0;
+
+	while(!open_nodes[0].empty() && !open_nodes[1].empty()) {
+		// no path through the rest of either side can be cheaper - the
+		// tops may be outdated, but only too low
+		if(open_nodes[0].top().first >= best_cost || open_nodes[1].top().first >= best_cost)
+			break;
+
+		if(expansions == limits.maxExpansions) {
+			limited = true;
+			unproven = true;
+			break;
+		}
+
+		// expand the smaller side
+		int d = open_nodes[0].size() <= open_nodes[1].size() ? 0 : 1;
+		T current(open_nodes[d].top().second);
+		open_nodes[d].pop();
+
+		typename SearchNodes::iterator current_it = nodes[d].find(current);
+		if(current_it->second.closed)
+			continue;
+		current_it->second.closed = true;
+		expansions++;
+
+		if(d == 0 && (limits.maxCost != INT_MAX || limits.maxExpansions != UINT_MAX)) {
+			int this_h = h(current);
+			if(this_h < best_h) {
+				best = current;
+				best_h = this_h;
+			}
+		}
+
+		unsigned int num_children = g(current, children);
+		assert(num_children <= MaxNeighbours);
+		for(unsigned int i = 0; i < num_children; i++) {
+			const T& child = children[i];
+			typename SearchNodes::iterator child_it = nodes[d].find(child);
+			if(child_it != nodes[d].end() && child_it->second.closed)
+				continue;
+
+			// backwards the edges are walked against their direction
+			int edge_cost = d == 0 ? c(current, child) : c(child, current);
+			if(edge_cost < 0) {
+				fprintf(stderr, "A* error: negative edge cost\n");
+				continue;
+			}
+			int this_g_cost = current_it->second.g + edge_cost;
+			int this_f_cost = this_g_cost + (d == 0 ? h(child) : rh(child));
+			if(this_f_cost > limits.maxCost) {
+				limited = true;
+				continue;
+			}
+			if(!relax(nodes[d], open_nodes[d], current, this_g_cost, this_f_cost, child))
+				continue;
+
+			typename SearchNodes::const_iterator other_it = nodes[1 - d].find(child);
+			if(other_it != nodes[1 - d].end() && this_g_cost + other_it->second.g < best_cost) {
+				best_cost = this_g_cost + other_it->second.g;
+				meeting = child;
+			}
+		}
+	}
+
+	if(best_cost < INT_MAX && best_cost <= limits.maxCost) {
+		// start to the meeting node, then its parents on the backward side
+		path.push_front(meeting);
+		tracePath(nodes[0], meeting, path);
+		T node = meeting;
+		while(1) {
+			const SearchNode& n = nodes[1].find(node)->second;
+			if(!n.hasParent)
+				break;
+			node = n.parent;
+			path.push_back(node);
+		}
+		if(status)
+			*status = unproven ? Status::LimitReached : Status::Found;
+	} else if(limited) {
+		path.push_front(best);
+		tracePath(nodes[0], best, path);
+		if(status)
+			*status = Status::LimitReached;
+	} else {
+		if(status)
+			*status = Status::Unreachable;
+	}
+#ifdef DEBUG_ASTAR
+	printPath(path);
+#endif
+	return path;
+}
+
+template<typename T>
+void AStar<T>::tracePath(const SearchNodes& nodes, const T& node, std::list<T>& path)
+{
+	const SearchNode* n = &nodes.find(node)->second;
+	while(n->hasParent) {
+		path.push_front(n->parent);
+		n = &nodes.find(n->parent)->second;
+	}
+}
+
+template<typename T>
+bool AStar<T>::relax(SearchNodes& nodes, OpenList& open_nodes, const T& parent,
+		int g_cost, int f_cost, const T& child)
+{
+	typename SearchNodes::iterator child_it = nodes.find(child);
+	if(child_it == nodes.end()) {
+		SearchNode n = { g_cost, false, true, parent };
+		nodes.insert(std::make_pair(child, n));
+	} else if(child_it->second.g > g_cost) {
+		child_it->second.g = g_cost;
+		child_it->second.hasParent = true;
+		child_it->second.parent = parent;
+	} else {
+		return false;
+	}
+	open_nodes.push(std::make_pair(f_cost, child));
+	return true;
+}
+
 template<typename T>
 void AStar<T>::printPath(const std::list<T>& path)
 {
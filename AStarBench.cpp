@@ -0,0 +1,362 @@
+#include <stdlib.h>
+
+#include "Clock.h"
+#include "AStar.h"
+#include "DStarLite.h"
+#include "FlowField.h"
+#include "GridAStar.h"
+#include "HPAStar.h"
+#include "PathCache.h"
+
+using namespace Common;
+
+static const unsigned int GRID_SIZE = 256;
+static const int NUM_SEARCHES = 20;
+
+static unsigned long solveGeneric(const GridAStar& grid, const Point2& start, const Point2& goalPoint)
+{
+	const int w = grid.getWidth();
+	int goal = goalPoint.y * w + goalPoint.x;
+	return AStar<int>::solve([&] (const int& c) {
+			std::set<int> ret;
+			int x = c % w, y = c / w;
+			for(int d = 0; d < 8; d++) {
+				if(grid.canMove(x, y, d))
+					ret.insert((y + GridAStar::MOVE_DY[d]) * w + x + GridAStar::MOVE_DX[d]);
+			}
+			return ret; },
+			[&] (const int& a, const int& b) {
+			return (a % w != b % w && a / w != b / w) ? GridAStar::DIAGONAL_COST : GridAStar::ORTHOGONAL_COST; },
+			[&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), goalPoint); },
+			[&] (const int& c) { return c == goal; },
+			start.y * w + start.x).size();
+}
+
+static unsigned long searchGeneric(const GridAStar& grid, const Point2& start, const Point2& goalPoint,
+		bool bidirectional)
+{
+	const int w = grid.getWidth();
+	int goal = goalPoint.y * w + goalPoint.x;
+	auto neighbours = [&] (const int& c, int* out) {
+		unsigned int num = 0;
+		int x = c % w, y = c / w;
+		for(int d = 0; d < 8; d++) {
+			if(grid.canMove(x, y, d))
+				out[num++] = (y + GridAStar::MOVE_DY[d]) * w + x + GridAStar::MOVE_DX[d];
+		}
+		return num; };
+	auto cost = [&] (const int& a, const int& b) {
+		return (a % w != b % w && a / w != b / w) ? GridAStar::DIAGONAL_COST : GridAStar::ORTHOGONAL_COST; };
+	auto heuristic = [&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), goalPoint); };
+	if(bidirectional) {
+		return AStar<int>::searchBidirectional(neighbours, cost, heuristic,
+				[&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), start); },
+				start.y * w + start.x, goal).size();
+	}
+	return AStar<int>::search(neighbours, cost, heuristic,
+			[&] (const int& c) { return c == goal; },
+			start.y * w + start.x).size();
+}
+
+static bool benchGrid(const char* name, GridAStar& grid)
+{
+	std::vector<std::pair<Point2, Point2>> searches;
+	while(searches.size() < NUM_SEARCHES) {
+		Point2 start(rand() % GRID_SIZE, rand() % GRID_SIZE);
+		Point2 goal(rand() % GRID_SIZE, rand() % GRID_SIZE);
+		if(grid.isPassable(start.x, start.y) && grid.isPassable(goal.x, goal.y))
+			searches.push_back(std::make_pair(start, goal));
+	}
+
+	double t0 = Clock::getTime();
+	unsigned long total1 = 0;
+	for(auto& s : searches) {
+		total1 += solveGeneric(grid, s.first, s.second);
+	}
+
+	double t1 = Clock::getTime();
+	unsigned long total5 = 0;
+	for(auto& s : searches) {
+		total5 += searchGeneric(grid, s.first, s.second, false);
+	}
+
+	double t6 = Clock::getTime();
+	unsigned long total6 = 0;
+	for(auto& s : searches) {
+		total6 += searchGeneric(grid, s.first, s.second, true);
+	}
+
+	double t7 = Clock::getTime();
+	unsigned long total2 = 0;
+	unsigned long expansions2 = 0;
+	std::vector<Point2> path;
+	for(auto& s : searches) {
+		grid.findPath(s.first, s.second, path);
+		total2 += path.size();
+		expansions2 += grid.getExpansions();
+	}
+
+	double t2 = Clock::getTime();
+	unsigned long total3 = 0;
+	unsigned long expansions3 = 0;
+	for(auto& s : searches) {
+		grid.findPathJPS(s.first, s.second, path);
+		total3 += path.size();
+		expansions3 += grid.getExpansions();
+	}
+
+	double t3 = Clock::getTime();
+	grid.buildJumpTable();
+
+	double t4 = Clock::getTime();
+	unsigned long total4 = 0;
+	for(auto& s : searches) {
+		grid.findPathJPS(s.first, s.second, path);
+		total4 += path.size();
+	}
+
+	double t5 = Clock::getTime();
+
+	printf("A* %dx%d %s grid, %d searches: generic %.3f s, inlined %.3f s, bidirectional %.3f s, "
+			"grid %.3f s (%lu expansions), JPS %.3f s (%lu expansions), JPS+ %.3f s (table %.3f s)\n",
+			GRID_SIZE, GRID_SIZE, name, NUM_SEARCHES, t1 - t0, t6 - t1, t7 - t6, t2 - t7, expansions2,
+			t3 - t2, expansions3, t5 - t4, t4 - t3);
+
+	// the paths may differ but not in whether one was found
+	if((total1 == 0) != (total2 == 0) || (total2 == 0) != (total3 == 0) || (total3 == 0) != (total4 == 0) ||
+			(total1 == 0) != (total5 == 0) || (total1 == 0) != (total6 == 0)) {
+		printf("A*: results differ\n");
+		return false;
+	}
+	return true;
+}
+
+// mostly open with some walls
+static void addWalls(GridAStar& grid, int num)
+{
+	for(int i = 0; i < num; i++) {
+		int x = rand() % grid.getWidth();
+		int y = rand() % grid.getHeight();
+		bool vertical = rand() % 2;
+		for(int j = 0; j < 40; j++) {
+			if(grid.isPassable(vertical ? x : x + j, vertical ? y + j : y))
+				grid.setPassable(vertical ? x : x + j, vertical ? y + j : y, false);
+		}
+	}
+}
+
+int astar_grid(int argc, char** argv)
+{
+	std::vector<bool> passable(GRID_SIZE * GRID_SIZE);
+	for(unsigned int i = 0; i < passable.size(); i++)
+		passable[i] = rand() % 100 >= 25;
+	GridAStar noisy(GRID_SIZE, GRID_SIZE, passable);
+
+	passable.assign(GRID_SIZE * GRID_SIZE, true);
+	GridAStar open(GRID_SIZE, GRID_SIZE, passable);
+	addWalls(open, 40);
+
+	bool ok = benchGrid("noisy", noisy);
+	ok = benchGrid("open", open) && ok;
+	return ok ? 0 : 1;
+}
+
+int astar_hpa(int argc, char** argv)
+{
+	// corner to corner searches on growing maps of the same kind
+	for(unsigned int size = 256; size <= 1024; size *= 2) {
+		GridAStar grid(size, size, std::vector<bool>(size * size, true));
+		addWalls(grid, size * size / 1600);
+
+		double t0 = Clock::getTime();
+		HPAStar hpa(grid);
+
+		double t1 = Clock::getTime();
+		std::vector<Point2> path;
+		unsigned long total1 = 0;
+		for(int i = 0; i < NUM_SEARCHES; i++) {
+			Point2 start(rand() % 16, rand() % 16);
+			Point2 goal(size - 1 - rand() % 16, size - 1 - rand() % 16);
+			grid.findPath(start, goal, path);
+			total1 += path.size();
+		}
+
+		double t2 = Clock::getTime();
+		unsigned long total2 = 0;
+		for(int i = 0; i < NUM_SEARCHES; i++) {
+			Point2 start(rand() % 16, rand() % 16);
+			Point2 goal(size - 1 - rand() % 16, size - 1 - rand() % 16);
+			hpa.findAbstractPath(start, goal, path);
+			total2 += path.size();
+		}
+
+		double t3 = Clock::getTime();
+
+		printf("HPA* %dx%d grid, %d searches: build %.3f s (%u nodes), A* %.3f s, abstract %.3f s\n",
+				size, size, NUM_SEARCHES, t1 - t0, hpa.getNumNodes(), t2 - t1, t3 - t2);
+
+		if((total1 == 0) != (total2 == 0)) {
+			printf("HPA*: results differ\n");
+			return 1;
+		}
+	}
+	return 0;
+}
+
+int astar_flowfield(int argc, char** argv)
+{
+	// many agents heading for the same goal
+	const int NUM_AGENTS = 500;
+	GridAStar grid(GRID_SIZE, GRID_SIZE, std::vector<bool>(GRID_SIZE * GRID_SIZE, true));
+	addWalls(grid, 40);
+
+	std::vector<unsigned char> costs(GRID_SIZE * GRID_SIZE);
+	for(unsigned int y = 0; y < GRID_SIZE; y++) {
+		for(unsigned int x = 0; x < GRID_SIZE; x++)
+			costs[y * GRID_SIZE + x] = grid.isPassable(x, y) ? 1 : 0;
+	}
+	FlowFieldMap map(GRID_SIZE, GRID_SIZE, costs);
+
+	Point2 goal(GRID_SIZE / 2, GRID_SIZE / 2);
+	grid.setPassable(goal.x, goal.y, true);
+	map.setCost(goal.x, goal.y, 1);
+	std::vector<Point2> agents;
+	while(agents.size() < NUM_AGENTS) {
+		Point2 p(rand() % GRID_SIZE, rand() % GRID_SIZE);
+		if(grid.isPassable(p.x, p.y))
+			agents.push_back(p);
+	}
+
+	double t0 = Clock::getTime();
+	std::vector<Point2> path;
+	int found1 = 0;
+	for(auto& a : agents) {
+		found1 += grid.findPath(a, goal, path);
+	}
+
+	double t1 = Clock::getTime();
+	std::shared_ptr<const FlowField> field = map.getField(goal);
+	double t2 = Clock::getTime();
+	int found2 = 0;
+	for(auto& a : agents) {
+		Point2 cell = a;
+		Point2 next;
+		while(field->getNext(cell, next))
+			cell = next;
+		found2 += cell.x == goal.x && cell.y == goal.y;
+	}
+	double t3 = Clock::getTime();
+
+	printf("Flow field, %d agents: A* %.3f s, field build %.3f s, following %.3f s\n",
+			NUM_AGENTS, t1 - t0, t2 - t1, t3 - t2);
+
+	if(found1 != found2) {
+		printf("Flow field: %d vs %d agents reach the goal\n", found1, found2);
+		return 1;
+	}
+	return 0;
+}
+
+int astar_dstarlite(int argc, char** argv)
+{
+	// an agent walking across the map while tiles near it change
+	const int NUM_STEPS = 200;
+	GridAStar grid(GRID_SIZE, GRID_SIZE, std::vector<bool>(GRID_SIZE * GRID_SIZE, true));
+	addWalls(grid, 40);
+	Point2 start(0, 0);
+	Point2 goal(GRID_SIZE - 1, GRID_SIZE - 1);
+	grid.setPassable(start.x, start.y, true);
+	grid.setPassable(goal.x, goal.y, true);
+
+	std::vector<Point2> changes;
+	for(int i = 0; i < NUM_STEPS; i++)
+		changes.push_back(Point2(rand() % GRID_SIZE, rand() % GRID_SIZE));
+
+	std::vector<Point2> path;
+	double times[2];
+	unsigned long expansions[2] = { 0, 0 };
+	unsigned long total[2] = { 0, 0 };
+	for(int incremental = 0; incremental < 2; incremental++) {
+		GridAStar g(grid);
+		DStarLite dstar(g, start, goal);
+		Point2 pos = start;
+		double t0 = Clock::getTime();
+		for(int i = 0; i < NUM_STEPS; i++) {
+			const Point2& c = changes[i];
+			if((c.x != pos.x || c.y != pos.y) && (c.x != goal.x || c.y != goal.y)) {
+				g.setPassable(c.x, c.y, !g.isPassable(c.x, c.y));
+				dstar.tileChanged(c.x, c.y);
+			}
+
+			if(incremental) {
+				dstar.findPath(path);
+				expansions[1] += dstar.getExpansions();
+			} else {
+				g.findPath(pos, goal, path);
+				expansions[0] += g.getExpansions();
+			}
+			total[incremental] += path.size();
+			if(path.size() > 1) {
+				pos = path[1];
+				dstar.setStart(pos);
+			}
+		}
+		times[incremental] = Clock::getTime() - t0;
+	}
+
+	printf("Replanning %d steps: A* %.3f s (%lu expansions), D* Lite %.3f s (%lu expansions)\n",
+			NUM_STEPS, times[0], expansions[0], times[1], expansions[1]);
+
+	if((total[0] == 0) != (total[1] == 0)) {
+		printf("D* Lite: results differ\n");
+		return 1;
+	}
+	return 0;
+}
+
+int astar_pathcache(int argc, char** argv)
+{
+	// units going back and forth between a few spots
+	const int NUM_QUERIES = 2000;
+	GridAStar grid(GRID_SIZE, GRID_SIZE, std::vector<bool>(GRID_SIZE * GRID_SIZE, true));
+	addWalls(grid, 40);
+
+	std::vector<Point2> spots;
+	for(int i = 0; i < 5; i++)
+		spots.push_back(Point2(rand() % (GRID_SIZE - 8), rand() % (GRID_SIZE - 8)));
+	std::vector<std::pair<Point2, Point2>> queries;
+	while(queries.size() < NUM_QUERIES) {
+		const Point2& s = spots[rand() % spots.size()];
+		const Point2& g = spots[rand() % spots.size()];
+		Point2 start(s.x + rand() % 8, s.y + rand() % 8);
+		Point2 goal(g.x + rand() % 8, g.y + rand() % 8);
+		if(grid.isPassable(start.x, start.y) && grid.isPassable(goal.x, goal.y))
+			queries.push_back(std::make_pair(start, goal));
+	}
+
+	std::vector<Point2> path;
+	double t0 = Clock::getTime();
+	unsigned long total1 = 0;
+	for(auto& q : queries) {
+		grid.findPath(q.first, q.second, path);
+		total1 += path.size();
+	}
+
+	double t1 = Clock::getTime();
+	PathCache cache(grid);
+	unsigned long total2 = 0;
+	for(auto& q : queries) {
+		cache.findPath(q.first, q.second, path);
+		total2 += path.size();
+	}
+	double t2 = Clock::getTime();
+
+	printf("Path cache, %d queries: A* %.3f s, cached %.3f s (%u hits, %u misses), path length %.3fx\n",
+			NUM_QUERIES, t1 - t0, t2 - t1, cache.getHits(), cache.getMisses(),
+			total1 ? total2 / double(total1) : 0.0);
+	if((total1 == 0) != (total2 == 0)) {
+		printf("Path cache: results differ\n");
+		return 1;
+	}
+	return 0;
+}
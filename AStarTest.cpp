@@ -0,0 +1,694 @@
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "AStar.h"
+#include "DStarLite.h"
+#include "FlowField.h"
+#include "GridAStar.h"
+#include "HPAStar.h"
+#include "PathCache.h"
+#include "PathService.h"
+#include "Steering.h"
+
+using namespace Common;
+
+static std::vector<bool> getRandomGrid(unsigned int w, unsigned int h, int blockedPercent)
+{
+	std::vector<bool> grid(w * h);
+	for(unsigned int i = 0; i < w * h; i++)
+		grid[i] = rand() % 100 >= blockedPercent;
+	return grid;
+}
+
+// generic A* over cell ids with the same moves as GridAStar
+static std::list<int> solveGeneric(const GridAStar& grid, bool diagonals, int start, int goal)
+{
+	int w = grid.getWidth();
+	Point2 goalPoint(goal % w, goal / w);
+	return AStar<int>::solve([&] (const int& c) {
+			std::set<int> ret;
+			int x = c % w, y = c / w;
+			for(int dy = -1; dy <= 1; dy++) {
+				for(int dx = -1; dx <= 1; dx++) {
+					if((dx == 0 && dy == 0) || (!diagonals && dx && dy))
+						continue;
+					if(!grid.isPassable(x + dx, y + dy) ||
+							!grid.isPassable(x + dx, y) || !grid.isPassable(x, y + dy))
+						continue;
+					ret.insert((y + dy) * w + x + dx);
+				}
+			}
+			return ret; },
+			[&] (const int& a, const int& b) {
+			return (a % w != b % w && a / w != b / w) ? GridAStar::DIAGONAL_COST : GridAStar::ORTHOGONAL_COST; },
+			[&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), goalPoint); },
+			[&] (const int& c) { return c == goal; },
+			start);
+}
+
+// the same with inlined callbacks, optionally from both ends
+static std::list<int> searchGeneric(const GridAStar& grid, bool diagonals, int start, int goal,
+		bool bidirectional = false, const AStar<int>::Limits& limits = AStar<int>::Limits(),
+		AStar<int>::Status* status = nullptr)
+{
+	int w = grid.getWidth();
+	Point2 startPoint(start % w, start / w);
+	Point2 goalPoint(goal % w, goal / w);
+	auto neighbours = [&] (const int& c, int* out) {
+		unsigned int num = 0;
+		int x = c % w, y = c / w;
+		for(int dy = -1; dy <= 1; dy++) {
+			for(int dx = -1; dx <= 1; dx++) {
+				if((dx == 0 && dy == 0) || (!diagonals && dx && dy))
+					continue;
+				if(!grid.isPassable(x + dx, y + dy) ||
+						!grid.isPassable(x + dx, y) || !grid.isPassable(x, y + dy))
+					continue;
+				out[num++] = (y + dy) * w + x + dx;
+			}
+		}
+		return num; };
+	auto cost = [&] (const int& a, const int& b) {
+		return (a % w != b % w && a / w != b / w) ? GridAStar::DIAGONAL_COST : GridAStar::ORTHOGONAL_COST; };
+	auto heuristic = [&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), goalPoint); };
+	if(bidirectional) {
+		return AStar<int>::searchBidirectional(neighbours, cost, heuristic,
+				[&] (const int& c) { return grid.heuristic(Point2(c % w, c / w), startPoint); },
+				start, goal, limits, status);
+	}
+	return AStar<int>::search(neighbours, cost, heuristic,
+			[&] (const int& c) { return c == goal; },
+			start, limits, status);
+}
+
+// cost of the path or -1 if it is not a valid path
+static int pathCost(const GridAStar& grid, const std::vector<Point2>& path)
+{
+	int cost = 0;
+	for(unsigned int i = 0; i < path.size(); i++) {
+		if(!grid.isPassable(path[i].x, path[i].y))
+			return -1;
+		if(i == 0)
+			continue;
+
+		int dx = path[i].x - path[i - 1].x;
+		int dy = path[i].y - path[i - 1].y;
+		if(abs(dx) > 1 || abs(dy) > 1 || (dx == 0 && dy == 0))
+			return -1;
+		if(dx && dy) {
+			if(!grid.isPassable(path[i - 1].x + dx, path[i - 1].y) ||
+					!grid.isPassable(path[i - 1].x, path[i - 1].y + dy))
+				return -1;
+			cost += GridAStar::DIAGONAL_COST;
+		} else {
+			cost += GridAStar::ORTHOGONAL_COST;
+		}
+	}
+	return cost;
+}
+
+int astar_grid(int argc, char** argv)
+{
+	std::vector<Point2> path;
+	for(int i = 0; i < 50; i++) {
+		unsigned int w = 5 + rand() % 60;
+		unsigned int h = 5 + rand() % 60;
+		bool diagonals = rand() % 2;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 40), diagonals);
+
+		for(int k = 0; k < 20; k++) {
+			Point2 start(rand() % w, rand() % h);
+			Point2 goal(rand() % w, rand() % h);
+			bool found = grid.findPath(start, goal, path);
+
+			std::list<int> expected;
+			if(grid.isPassable(start.x, start.y) && grid.isPassable(goal.x, goal.y))
+				expected = solveGeneric(grid, diagonals, start.y * w + start.x, goal.y * w + goal.x);
+
+			if(found != !expected.empty()) {
+				printf("GridAStar: path found: %d, expected %d\n", found, !expected.empty());
+				return 1;
+			}
+			if(!found)
+				continue;
+
+			std::vector<Point2> expectedPath;
+			for(auto c : expected)
+				expectedPath.push_back(Point2(c % w, c / w));
+
+			int cost = pathCost(grid, path);
+			int expectedCost = pathCost(grid, expectedPath);
+			if(cost != expectedCost || path.front().x != start.x || path.front().y != start.y ||
+					path.back().x != goal.x || path.back().y != goal.y) {
+				printf("GridAStar: path cost %d, expected %d\n", cost, expectedCost);
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 50 tests.\n");
+	return 0;
+}
+
+int astar_jps(int argc, char** argv)
+{
+	std::vector<Point2> expected;
+	std::vector<Point2> path;
+	for(int i = 0; i < 50; i++) {
+		unsigned int w = 5 + rand() % 100;
+		unsigned int h = 5 + rand() % 100;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 40));
+		GridAStar jpsPlus(w, h, getRandomGrid(w, h, 0));
+		for(unsigned int y = 0; y < h; y++) {
+			for(unsigned int x = 0; x < w; x++) {
+				jpsPlus.setPassable(x, y, grid.isPassable(x, y));
+			}
+		}
+		jpsPlus.buildJumpTable();
+
+		for(int k = 0; k < 20; k++) {
+			Point2 start(rand() % w, rand() % h);
+			Point2 goal(rand() % w, rand() % h);
+			bool found = grid.findPath(start, goal, expected);
+			int expectedCost = pathCost(grid, expected);
+
+			for(GridAStar* g : { &grid, &jpsPlus }) {
+				bool jpsFound = g->findPathJPS(start, goal, path);
+				int cost = pathCost(grid, path);
+				if(jpsFound != found || cost != expectedCost ||
+						(found && (path.front().x != start.x || path.front().y != start.y ||
+							   path.back().x != goal.x || path.back().y != goal.y))) {
+					printf("GridAStar: %s path cost %d, expected %d\n",
+							g->hasJumpTable() ? "JPS+" : "JPS", cost, expectedCost);
+					return 1;
+				}
+			}
+		}
+	}
+
+	// an open map with a few walls should need far fewer expansions
+	GridAStar open(200, 200, getRandomGrid(200, 200, 0));
+	for(int i = 0; i < 20; i++) {
+		int x = rand() % 200;
+		int y = rand() % 200;
+		for(int j = 0; j < 30 && y + j < 200; j++)
+			open.setPassable(x, y + j, false);
+	}
+	Point2 start(0, 0);
+	Point2 goal(199, 199);
+	open.findPath(start, goal, path);
+	unsigned int astarExpansions = open.getExpansions();
+	open.findPathJPS(start, goal, path);
+	unsigned int jpsExpansions = open.getExpansions();
+	if(jpsExpansions * 10 > astarExpansions) {
+		printf("GridAStar: JPS expanded %u cells, A* %u\n", jpsExpansions, astarExpansions);
+		return 1;
+	}
+
+	printf("Successfully passed 50 tests.\n");
+	return 0;
+}
+
+int astar_hpa(int argc, char** argv)
+{
+	std::vector<Point2> expected;
+	std::vector<Point2> path;
+	float total = 0.0f;
+	int numPaths = 0;
+	for(int i = 0; i < 30; i++) {
+		unsigned int w = 5 + rand() % 120;
+		unsigned int h = 5 + rand() % 120;
+		bool diagonals = rand() % 2;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 30), diagonals);
+		HPAStar hpa(grid, 4 + rand() % 16);
+
+		for(int k = 0; k < 40; k++) {
+			if(k % 10 == 9) {
+				// change some tiles, the hierarchy must follow
+				for(int j = 0; j < 20; j++) {
+					int x = rand() % w;
+					int y = rand() % h;
+					grid.setPassable(x, y, !grid.isPassable(x, y));
+					hpa.tileChanged(x, y);
+				}
+			}
+
+			Point2 start(rand() % w, rand() % h);
+			Point2 goal(rand() % w, rand() % h);
+			bool found = grid.findPath(start, goal, expected);
+			bool hpaFound = hpa.findPath(start, goal, path);
+			int cost = pathCost(grid, path);
+			if(found != hpaFound || cost == -1 ||
+					(found && (path.front().x != start.x || path.front().y != start.y ||
+						   path.back().x != goal.x || path.back().y != goal.y))) {
+				printf("HPAStar: path found: %d, expected %d, cost %d\n", hpaFound, found, cost);
+				return 1;
+			}
+
+			if(found && pathCost(grid, expected) > 0) {
+				total += cost / float(pathCost(grid, expected));
+				numPaths++;
+			}
+		}
+	}
+
+	// near optimal on average
+	if(numPaths && total / numPaths > 1.2f) {
+		printf("HPAStar: paths %.2f times optimal on average\n", total / numPaths);
+		return 1;
+	}
+
+	printf("Successfully passed 30 tests.\n");
+	return 0;
+}
+
+int astar_pathservice(int argc, char** argv)
+{
+	for(int i = 0; i < 10; i++) {
+		unsigned int w = 20 + rand() % 100;
+		unsigned int h = 20 + rand() % 100;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 30));
+
+		std::vector<std::pair<Point2, Point2>> requests;
+		for(int k = 0; k < 100; k++)
+			requests.push_back(std::make_pair(Point2(rand() % w, rand() % h), Point2(rand() % w, rand() % h)));
+
+		std::vector<int> expected;
+		std::vector<Point2> path;
+		for(auto& r : requests) {
+			grid.findPath(r.first, r.second, path);
+			expected.push_back(pathCost(grid, path));
+		}
+
+		PathService service(grid, 4);
+		std::vector<unsigned int> ids;
+		std::vector<std::future<PathService::Result>> futures;
+		for(auto& r : requests) {
+			ids.push_back(service.request(r.first, r.second, rand() % 3));
+			futures.push_back(service.requestFuture(r.first, r.second, rand() % 3,
+						PathService::Method::JPS));
+		}
+		service.wait();
+
+		std::vector<PathService::Result> results;
+		service.poll(results);
+		if(results.size() != requests.size() || service.pending() != 0) {
+			printf("PathService: %zu results, expected %zu\n", results.size(), requests.size());
+			return 1;
+		}
+
+		for(auto& res : results) {
+			unsigned int k = std::find(ids.begin(), ids.end(), res.id) - ids.begin();
+			if(k == ids.size() || pathCost(grid, res.path) != expected[k] ||
+					pathCost(grid, futures[k].get().path) != expected[k]) {
+				printf("PathService: wrong path for request %u\n", res.id);
+				return 1;
+			}
+		}
+	}
+
+	// without workers, update() goes by priority and then in order
+	GridAStar grid(50, 50, getRandomGrid(50, 50, 0));
+	PathService service(grid, 0);
+	unsigned int low = service.request(Point2(0, 0), Point2(49, 49), 0);
+	unsigned int high = service.request(Point2(0, 0), Point2(49, 49), 5);
+	unsigned int low2 = service.request(Point2(0, 0), Point2(49, 49), 0);
+	std::vector<PathService::Result> results;
+	while(service.update(0.0))
+		service.poll(results, 1);
+	service.poll(results);
+	if(results.size() != 3 || results[0].id != high || results[1].id != low || results[2].id != low2) {
+		printf("PathService: requests solved in the wrong order\n");
+		return 1;
+	}
+
+	printf("Successfully passed 10 tests.\n");
+	return 0;
+}
+
+int astar_flowfield(int argc, char** argv)
+{
+	std::vector<Point2> path;
+	for(int i = 0; i < 30; i++) {
+		unsigned int w = 5 + rand() % 100;
+		unsigned int h = 5 + rand() % 100;
+		std::vector<bool> passable = getRandomGrid(w, h, rand() % 30);
+		GridAStar grid(w, h, passable);
+
+		// with unit costs the distances are the A* path costs
+		bool weighted = i % 2;
+		std::vector<unsigned char> costs(w * h);
+		for(unsigned int j = 0; j < w * h; j++)
+			costs[j] = passable[j] ? (weighted ? 1 + rand() % 5 : 1) : 0;
+		FlowFieldMap map(w, h, costs, 2.0f, Vector2(-10.0f, 5.0f), 4);
+
+		Point2 goal(rand() % w, rand() % h);
+		std::shared_ptr<const FlowField> field = map.getField(goal);
+		if(map.getField(goal) != field || map.getNumFields() != 1) {
+			printf("FlowField: field not cached\n");
+			return 1;
+		}
+
+		for(int k = 0; k < 50; k++) {
+			Point2 start(rand() % w, rand() % h);
+			int dist = field->getDistance(start.x, start.y);
+			if(!weighted) {
+				bool found = grid.findPath(start, goal, path);
+				if(found != (dist >= 0) || (found && pathCost(grid, path) != dist)) {
+					printf("FlowField: distance %d, expected %d\n", dist, found ? pathCost(grid, path) : -1);
+					return 1;
+				}
+			}
+			if(dist < 0)
+				continue;
+
+			// following the directions reaches the goal at the integrated cost
+			int cost = 0;
+			Point2 cell = start;
+			Point2 next;
+			while(field->getNext(cell, next)) {
+				bool diagonal = next.x != cell.x && next.y != cell.y;
+				cost += costs[cell.y * w + cell.x] *
+					(diagonal ? FlowFieldMap::DIAGONAL_COST : FlowFieldMap::ORTHOGONAL_COST);
+				cell = next;
+			}
+			if(cell.x != goal.x || cell.y != goal.y || cost != dist) {
+				printf("FlowField: following the field costs %d, expected %d\n", cost, dist);
+				return 1;
+			}
+
+			Vehicle v(1.0f, 3.0f, 10.0f);
+			v.setPosition(map.getCellCenter(start));
+			Vector3 expected = field->getDirection(start.x, start.y) * 3.0f;
+			if(start.x == goal.x && start.y == goal.y)
+				expected = Vector3();
+			if((Steering(v).followFlowField(*field) - expected).length() > 0.001f) {
+				printf("FlowField: wrong steering force\n");
+				return 1;
+			}
+		}
+
+		// at most maxFields are kept, and changing costs discards them
+		for(int k = 0; k < 10; k++)
+			map.getField(Point2(rand() % w, rand() % h));
+		if(map.getNumFields() > 4) {
+			printf("FlowField: %u fields cached\n", map.getNumFields());
+			return 1;
+		}
+		int goalDist = field->getDistance(goal.x, goal.y);
+		map.setCost(goal.x, goal.y, goalDist == 0 ? 0 : 1);
+		if(map.getNumFields() != 0 || field->getDistance(goal.x, goal.y) != goalDist ||
+				map.getField(goal)->getDistance(goal.x, goal.y) != (goalDist == 0 ? -1 : 0)) {
+			printf("FlowField: field not invalidated\n");
+			return 1;
+		}
+	}
+
+	printf("Successfully passed 30 tests.\n");
+	return 0;
+}
+
+int astar_dstarlite(int argc, char** argv)
+{
+	std::vector<Point2> expected;
+	std::vector<Point2> path;
+	for(int i = 0; i < 30; i++) {
+		unsigned int w = 5 + rand() % 80;
+		unsigned int h = 5 + rand() % 80;
+		bool diagonals = rand() % 2;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 30), diagonals);
+		Point2 start(rand() % w, rand() % h);
+		Point2 goal(rand() % w, rand() % h);
+		DStarLite dstar(grid, start, goal);
+
+		// tiles change and the agent moves along the path, and every
+		// replanned path must be as short as a new search would find
+		for(int k = 0; k < 50; k++) {
+			if(k == 25) {
+				goal = Point2(rand() % w, rand() % h);
+				dstar.setGoal(goal);
+			}
+
+			bool found = dstar.findPath(path);
+			bool expectedFound = grid.findPath(dstar.getStart(), goal, expected);
+			if(found != expectedFound || pathCost(grid, path) != pathCost(grid, expected) ||
+					(found && (path.front().x != dstar.getStart().x || path.front().y != dstar.getStart().y ||
+						   path.back().x != goal.x || path.back().y != goal.y))) {
+				printf("D* Lite: path cost %d, expected %d\n", pathCost(grid, path), pathCost(grid, expected));
+				return 1;
+			}
+
+			if(path.size() > 1 && rand() % 2)
+				dstar.setStart(path[1]);
+
+			for(int j = rand() % 5; j >= 0; j--) {
+				int x = rand() % w;
+				int y = rand() % h;
+				grid.setPassable(x, y, !grid.isPassable(x, y));
+				dstar.tileChanged(x, y);
+			}
+		}
+	}
+
+	printf("Successfully passed 30 tests.\n");
+	return 0;
+}
+
+int astar_search(int argc, char** argv)
+{
+	for(int i = 0; i < 50; i++) {
+		unsigned int w = 5 + rand() % 60;
+		unsigned int h = 5 + rand() % 60;
+		bool diagonals = rand() % 2;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 40), diagonals);
+
+		for(int k = 0; k < 20; k++) {
+			int start = rand() % (w * h);
+			int goal = rand() % (w * h);
+			if(!grid.isPassable(start % w, start / w) || !grid.isPassable(goal % w, goal / w))
+				continue;
+
+			std::vector<Point2> paths[2];
+			std::list<int> expected = solveGeneric(grid, diagonals, start, goal);
+			std::list<int> found = searchGeneric(grid, diagonals, start, goal);
+			for(auto c : expected)
+				paths[0].push_back(Point2(c % w, c / w));
+			for(auto c : found)
+				paths[1].push_back(Point2(c % w, c / w));
+
+			if(paths[0].empty() != paths[1].empty() || pathCost(grid, paths[0]) != pathCost(grid, paths[1]) ||
+					(!found.empty() && (found.front() != start || found.back() != goal))) {
+				printf("AStar::search: path cost %d, expected %d\n",
+						pathCost(grid, paths[1]), pathCost(grid, paths[0]));
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 50 tests.\n");
+	return 0;
+}
+
+static std::vector<Point2> toPoints(const std::list<int>& path, unsigned int w)
+{
+	std::vector<Point2> ret;
+	for(auto c : path)
+		ret.push_back(Point2(c % w, c / w));
+	return ret;
+}
+
+int astar_bidirectional(int argc, char** argv)
+{
+	typedef AStar<int>::Status Status;
+	typedef AStar<int>::Limits Limits;
+	for(int i = 0; i < 50; i++) {
+		unsigned int w = 5 + rand() % 60;
+		unsigned int h = 5 + rand() % 60;
+		bool diagonals = rand() % 2;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 40), diagonals);
+
+		for(int k = 0; k < 20; k++) {
+			int start = rand() % (w * h);
+			int goal = rand() % (w * h);
+			if(!grid.isPassable(start % w, start / w) || !grid.isPassable(goal % w, goal / w))
+				continue;
+
+			Status status;
+			std::vector<Point2> expected = toPoints(searchGeneric(grid, diagonals, start, goal), w);
+			int expectedCost = pathCost(grid, expected);
+			for(int bidirectional = 0; bidirectional < 2; bidirectional++) {
+				// without limits, with the cost limit just high enough and
+				// with as many expansions as a search could need
+				for(int limit = 0; limit < 3; limit++) {
+					Limits limits;
+					if(limit == 1 && !expected.empty())
+						limits.maxCost = expectedCost;
+					if(limit == 2)
+						limits.maxExpansions = 2 * w * h;
+					std::vector<Point2> path = toPoints(searchGeneric(grid, diagonals, start, goal,
+								bidirectional, limits, &status), w);
+					if((status == Status::Found) != !expected.empty() ||
+							(status != Status::Found && status != Status::Unreachable) ||
+							pathCost(grid, path) != expectedCost ||
+							(!path.empty() && (int(path.front().y * w + path.front().x) != start ||
+									   int(path.back().y * w + path.back().x) != goal))) {
+						printf("AStar%s: path cost %d, expected %d\n",
+								bidirectional ? "::searchBidirectional" : "::search",
+								pathCost(grid, path), expectedCost);
+						return 1;
+					}
+				}
+
+				// too low limits give a partial path from the start, which
+				// at least doesn't lead further away
+				int startH = grid.heuristic(Point2(start % w, start / w), Point2(goal % w, goal / w));
+				for(int limit = 0; limit < 2; limit++) {
+					Limits limits;
+					if(limit == 0) {
+						if(expected.size() < 2)
+							continue;
+						limits.maxCost = expectedCost - 1;
+					} else {
+						limits.maxExpansions = 1 + rand() % 5;
+					}
+					std::vector<Point2> path = toPoints(searchGeneric(grid, diagonals, start, goal,
+								bidirectional, limits, &status), w);
+					// a short path may be found, or a small component searched
+					// through, within a few expansions
+					if(status == Status::Found && pathCost(grid, path) != expectedCost) {
+						printf("AStar: limited search found path cost %d, expected %d\n",
+								pathCost(grid, path), expectedCost);
+						return 1;
+					}
+					if(status == Status::Found || (status == Status::Unreachable && expected.empty()))
+						continue;
+					if(status != Status::LimitReached || pathCost(grid, path) < 0 || path.empty() ||
+							int(path.front().y * w + path.front().x) != start ||
+							grid.heuristic(path.back(), Point2(goal % w, goal / w)) > startH) {
+						printf("AStar: wrong partial path, status %d\n", int(status));
+						return 1;
+					}
+				}
+			}
+		}
+	}
+
+	// Every expansion limit on small grids: a bidirectional search may
+	// have found a path and then be stopped before proving it the
+	// shortest, which mustn't be reported as Found.
+	int unproven = 0;
+	for(int i = 0; i < 100; i++) {
+		unsigned int w = 6 + rand() % 10;
+		unsigned int h = 6 + rand() % 10;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 30), true);
+		int start = rand() % (w * h);
+		int goal = rand() % (w * h);
+		if(!grid.isPassable(start % w, start / w) || !grid.isPassable(goal % w, goal / w))
+			continue;
+
+		int expectedCost = pathCost(grid, toPoints(searchGeneric(grid, true, start, goal), w));
+		Status status = Status::LimitReached;
+		for(unsigned int limit = 1; status == Status::LimitReached; limit++) {
+			std::vector<Point2> path = toPoints(searchGeneric(grid, true, start, goal,
+						true, Limits(INT_MAX, limit), &status), w);
+			if(status == Status::Found && pathCost(grid, path) != expectedCost) {
+				printf("AStar::searchBidirectional: %d expansions: found path cost %d, expected %d\n",
+						limit, pathCost(grid, path), expectedCost);
+				return 1;
+			}
+			if(status == Status::LimitReached && !path.empty() &&
+					int(path.back().y * w + path.back().x) == goal)
+				unproven++;
+		}
+	}
+	if(!unproven) {
+		printf("AStar::searchBidirectional: no search stopped after meeting\n");
+		return 1;
+	}
+
+	printf("Successfully passed 50 tests.\n");
+	return 0;
+}
+
+int astar_pathcache(int argc, char** argv)
+{
+	std::vector<Point2> path;
+	for(int i = 0; i < 20; i++) {
+		unsigned int w = 20 + rand() % 100;
+		unsigned int h = 20 + rand() % 100;
+		GridAStar grid(w, h, getRandomGrid(w, h, rand() % 20));
+		PathCache cache(grid, 4 + rand() % 8, 1 + rand() % 20);
+
+		// requests between a few spots
+		std::vector<Point2> spots;
+		for(int k = 0; k < 4; k++)
+			spots.push_back(Point2(rand() % (w - 4), rand() % (h - 4)));
+
+		for(int k = 0; k < 200; k++) {
+			const Point2& s = spots[rand() % spots.size()];
+			const Point2& g = spots[rand() % spots.size()];
+			Point2 start(s.x + rand() % 4, s.y + rand() % 4);
+			Point2 goal(g.x + rand() % 4, g.y + rand() % 4);
+
+			// paths must stay valid when tiles change, whether the cache
+			// is told or not
+			if(k % 20 == 19) {
+				int x = rand() % w;
+				int y = rand() % h;
+				grid.setPassable(x, y, !grid.isPassable(x, y));
+				if(rand() % 2)
+					cache.tileChanged(x, y);
+			}
+
+			bool found = cache.findPath(start, goal, path);
+			std::vector<Point2> expected;
+			bool expectedFound = grid.findPath(start, goal, expected);
+			if(found != expectedFound || (found && (pathCost(grid, path) < 0 ||
+						path.front().x != start.x || path.front().y != start.y ||
+						path.back().x != goal.x || path.back().y != goal.y))) {
+				printf("PathCache: invalid path\n");
+				return 1;
+			}
+		}
+
+		if(cache.getHits() == 0 || cache.getMisses() == 0) {
+			printf("PathCache: %u hits, %u misses\n", cache.getHits(), cache.getMisses());
+			return 1;
+		}
+	}
+
+	// only the paths through the changed region are dropped
+	GridAStar grid(64, 64, std::vector<bool>(64 * 64, true));
+	PathCache cache(grid, 8);
+	cache.findPath(Point2(1, 1), Point2(62, 1), path);
+	cache.findPath(Point2(1, 62), Point2(62, 62), path);
+	grid.setPassable(30, 1, false);
+	cache.tileChanged(30, 1);
+	if(cache.size() != 1) {
+		printf("PathCache: %u paths left\n", cache.size());
+		return 1;
+	}
+	grid.setPassable(30, 1, true);
+	cache.findPath(Point2(1, 62), Point2(62, 62), path);
+	if(cache.size() != 1 || cache.getMisses() != 3 || cache.getHits() != 0) {
+		printf("PathCache: cache not cleared on a new grid version\n");
+		return 1;
+	}
+
+	// joining the cached path would need a long detour past the wall, so
+	// the local search gives up and the lookup is a miss
+	for(int x = 0; x <= 40; x++)
+		grid.setPassable(x, 3, false);
+	PathCache walled(grid, 8);
+	walled.findPath(Point2(1, 1), Point2(62, 1), path);
+	if(!walled.findPath(Point2(1, 5), Point2(62, 2), path) ||
+			walled.getMisses() != 2 || walled.getHits() != 0 ||
+			path.front().x != 1 || path.front().y != 5 || pathCost(grid, path) < 0) {
+		printf("PathCache: %u hits, %u misses with a wall\n", walled.getHits(), walled.getMisses());
+		return 1;
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
@@ -3,6 +3,8 @@
 
 #include <list>
 #include <vector>
+#include <utility>
+#include <algorithm>
 #include <cmath>
 #include <cassert>
 
@@ -14,7 +16,7 @@ namespace Common {
 
 template<class T>
 struct Cell {
-	std::list<T> members;
+	std::list<std::pair<T, Vector2>> members;
 	AABB box;
 	Cell(const AABB& b) : box(b) { }
 };
@@ -22,18 +24,34 @@ struct Cell {
 template<class T>
 class CellSpacePartition {
 	public:
-		// maxentities is the maximum number of T's returned by any single query
+		// maxentities is the initial capacity of the queryBegin() result buffer
 		inline CellSpacePartition(float w, float h,
-				unsigned int cellsx, unsigned int cellsy, unsigned int maxentities);
+				unsigned int cellsx, unsigned int cellsy, unsigned int maxentities = 0);
 		inline void add(T& t, const Vector2& p);
 		inline void remove(T& t, const Vector2& p);
 		inline void update(T& t, const Vector2& oldpos, const Vector2& newpos);
+		// queryBegin/queryNext/queryEnd share one cursor, so only one such query
+		// can be active at a time - use query() for reentrant or concurrent queries
 		inline T& queryBegin(const Vector2& p, float radius) const;
 		inline bool queryEnd() const;
 		inline T& queryNext() const;
+		// the query() overloads keep no state and are safe to call from
+		// several threads at once as long as nobody modifies the partition
+		inline void query(const AABB& area, std::vector<T>& out) const; // appends to out
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const; // calls visitor(const T&, const Vector2&)
+		// k nearest members to p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		// members within radius of p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const;
 
 	private:
 		inline unsigned int positionToIndex(const Vector2& p) const;
+		inline void positionToCell(const Vector2& p, int& i, int& j) const;
+		template<typename F>
+		inline void forEachCell(const AABB& area, F&& f) const;
 		std::vector<Cell<T>> mCells;
 		float mWidth;
 		float mHeight;
@@ -63,8 +81,8 @@ CellSpacePartition<T>::CellSpacePartition(float w, float h, unsigned int cellsx,
 {
 	mCellWidth  = ceil(mWidth  / (float)mNumCellsX);
 	mCellHeight = ceil(mHeight / (float)mNumCellsY);
-	for(int j = 0; j < mNumCellsY; j++) {
-		for(int i = 0; i < mNumCellsX; i++) {
+	for(unsigned int j = 0; j < mNumCellsY; j++) {
+		for(unsigned int i = 0; i < mNumCellsX; i++) {
 			mCells.push_back(Cell<T>(AABB(Vector2((i + 0.5f) * mCellWidth - mWidth * 0.5f,
 							(j + 0.5f) * mCellHeight - mHeight * 0.5f),
 						Vector2(mCellWidth * 0.5f,
@@ -74,21 +92,21 @@ CellSpacePartition<T>::CellSpacePartition(float w, float h, unsigned int cellsx,
 
 	std::cout << "Total " << mCells.size() << " cells.\n";
 
-	mQueryResult.resize(mMaxEntities);
+	mQueryResult.resize(std::max(1u, mMaxEntities));
 }
 
 template<class T>
 void CellSpacePartition<T>::add(T& t, const Vector2& p)
 {
 	auto i = positionToIndex(p);
-	mCells.at(i).members.push_back(t);
+	mCells.at(i).members.push_back(std::make_pair(t, p));
 }
 
 template<class T>
 void CellSpacePartition<T>::remove(T& t, const Vector2& p)
 {
 	auto i = positionToIndex(p);
-	mCells.at(i).members.remove(t);
+	mCells.at(i).members.remove_if([&t] (const std::pair<T, Vector2>& m) { return m.first == t; });
 }
 
 template<class T>
@@ -96,8 +114,15 @@ void CellSpacePartition<T>::update(T& t, const Vector2& oldpos, const Vector2& n
 {
 	auto i1 = positionToIndex(oldpos);
 	auto i2 = positionToIndex(newpos);
-	if(i1 == i2)
+	if(i1 == i2) {
+		for(auto& m : mCells.at(i1).members) {
+			if(m.first == t) {
+				m.second = newpos;
+				break;
+			}
+		}
 		return;
+	}
 
 	remove(t, oldpos);
 	add(t, newpos);
@@ -108,24 +133,20 @@ T& CellSpacePartition<T>::queryBegin(const Vector2& p, float radius) const
 {
 	AABB query(p, Vector2(radius, radius));
 
-	Vector2 minp = Vector2(clamp(mWidth * -0.5f, p.x - radius, mWidth * 0.5f - 0.01f), clamp(mHeight * -0.5f, p.y - radius, mHeight * 0.5f - 0.01f));
-	Vector2 maxp = Vector2(clamp(mWidth * -0.5f, p.x + radius, mWidth * 0.5f - 0.01f), clamp(mHeight * -0.5f, p.y + radius, mHeight * 0.5f - 0.01f));
-	unsigned int minx = positionToIndex(minp) % int(mNumCellsY);
-	unsigned int miny = positionToIndex(minp) / int(mNumCellsY);
-
-	unsigned int maxx = positionToIndex(maxp) % int(mNumCellsY);
-	unsigned int maxy = positionToIndex(maxp) / int(mNumCellsY);
-
 	mQueryResultNum = 0;
-	for(int j = miny; j <= maxy; j++) {
-		for(int i = minx; i <= maxx; i++) {
-			auto& c = mCells.at(j * mNumCellsY + i);
-			for(auto m : c.members) {
-				assert(mQueryResultNum < mQueryResult.size());
-				mQueryResult.at(mQueryResultNum++) = m;
+	forEachCell(query, [&] (const Cell<T>& c) {
+			for(auto& m : c.members) {
+				if(mQueryResultNum < mQueryResult.size())
+					mQueryResult[mQueryResultNum] = m.first;
+				else
+					mQueryResult.push_back(m.first);
+				mQueryResultNum++;
 			}
-		}
-	}
+			});
+
+	// keep one slot past the end valid for queryNext()
+	if(mQueryResult.size() <= mQueryResultNum)
+		mQueryResult.resize(mQueryResultNum + 1);
 
 	mQueryIndex = 0;
 
@@ -144,13 +165,117 @@ T& CellSpacePartition<T>::queryNext() const
 	return mQueryResult.at(++mQueryIndex);
 }
 
+template<class T>
+void CellSpacePartition<T>::query(const AABB& area, std::vector<T>& out) const
+{
+	query(area, [&out] (const T& t, const Vector2&) { out.push_back(t); });
+}
+
+template<class T>
+template<typename F>
+void CellSpacePartition<T>::query(const AABB& area, F&& visitor) const
+{
+	forEachCell(area, [&] (const Cell<T>& c) {
+			for(auto& m : c.members) {
+				if(area.contains(m.second))
+					visitor(m.first, m.second);
+			}
+			});
+}
+
+template<class T>
+void CellSpacePartition<T>::nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	if(k == 0)
+		return;
+
+	int ci, cj;
+	positionToCell(p, ci, cj);
+
+	// visit rings of cells around p until the next ring is too far away
+	float cellSize = std::min(mCellWidth, mCellHeight);
+	int maxRing = std::max(mNumCellsX, mNumCellsY);
+	for(int r = 0; r <= maxRing; r++) {
+		float ringDist = (r - 1) * cellSize;
+		if(r > 1 && ringDist * ringDist > nearestBound(out, k))
+			break;
+
+		for(int j = cj - r; j <= cj + r; j++) {
+			if(j < 0 || j >= int(mNumCellsY))
+				continue;
+
+			bool edgeRow = j == cj - r || j == cj + r;
+			int step = edgeRow || r == 0 ? 1 : 2 * r;
+			for(int i = ci - r; i <= ci + r; i += step) {
+				if(i < 0 || i >= int(mNumCellsX))
+					continue;
+
+				auto& c = mCells[j * mNumCellsX + i];
+				if(c.members.empty() || c.box.distance2(p) > nearestBound(out, k))
+					continue;
+
+				for(auto& m : c.members) {
+					pushNearest(out, k, p.distance2(m.second), m.first);
+				}
+			}
+		}
+	}
+
+	std::sort_heap(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+void CellSpacePartition<T>::withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+
+	float radius2 = radius * radius;
+	forEachCell(AABB(p, Vector2(radius, radius)), [&] (const Cell<T>& c) {
+			if(c.box.distance2(p) > radius2)
+				return;
+
+			for(auto& m : c.members) {
+				float d2 = p.distance2(m.second);
+				if(d2 <= radius2) {
+					out.push_back(std::make_pair(d2, m.first));
+				}
+			}
+			});
+
+	std::sort(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+template<typename F>
+void CellSpacePartition<T>::forEachCell(const AABB& area, F&& f) const
+{
+	int minx, miny, maxx, maxy;
+	positionToCell(area.center - area.halfDimension, minx, miny);
+	positionToCell(area.center + area.halfDimension, maxx, maxy);
+
+	for(int j = miny; j <= maxy; j++) {
+		for(int i = minx; i <= maxx; i++) {
+			f(mCells[j * mNumCellsX + i]);
+		}
+	}
+}
+
 template<class T>
 unsigned int CellSpacePartition<T>::positionToIndex(const Vector2& p) const
 {
-	int val = (int(p.y + mHeight * 0.5f) / int(mCellHeight)) * mNumCellsY + (int(p.x + mWidth * 0.5f) / int(mCellWidth));
+	int val = (int(p.y + mHeight * 0.5f) / int(mCellHeight)) * mNumCellsX + (int(p.x + mWidth * 0.5f) / int(mCellWidth));
 	return val;
 }
 
+template<class T>
+void CellSpacePartition<T>::positionToCell(const Vector2& p, int& i, int& j) const
+{
+	// clamped to the grid
+	i = clamp<int>(0, floor((p.x + mWidth * 0.5f) / int(mCellWidth)), mNumCellsX - 1);
+	j = clamp<int>(0, floor((p.y + mHeight * 0.5f) / int(mCellHeight)), mNumCellsY - 1);
+}
+
 }
 
 #endif
@@ -0,0 +1,64 @@
+#include <stdlib.h>
+
+#include "Clock.h"
+#include "CellSpacePartition.h"
+#include "FlatCellSpacePartition.h"
+
+using namespace Common;
+
+static const int NUM_ENTITIES = 20000;
+static const int NUM_FRAMES = 50;
+
+static Vector2 getRandomPoint()
+{
+	return Vector2(rand() % 1000 - 500, rand() % 1000 - 500);
+}
+
+int cellspacepartition_rebuild(int argc, char** argv)
+{
+	std::vector<int> ids;
+	std::vector<Vector2> positions;
+	for(int i = 0; i < NUM_ENTITIES; i++) {
+		ids.push_back(i);
+		positions.push_back(getRandomPoint());
+	}
+
+	CellSpacePartition<int> grid(1000, 1000, 50, 50, NUM_ENTITIES);
+	FlatCellSpacePartition<int> flat(1000, 1000, 50, 50);
+	for(int i = 0; i < NUM_ENTITIES; i++) {
+		grid.add(ids[i], positions[i]);
+	}
+
+	// every entity moves every frame
+	std::vector<std::vector<Vector2>> frames(NUM_FRAMES, positions);
+	for(int f = 1; f < NUM_FRAMES; f++) {
+		for(int i = 0; i < NUM_ENTITIES; i++) {
+			Vector2 p = frames[f - 1][i] + Vector2(rand() % 21 - 10, rand() % 21 - 10);
+			frames[f][i] = Vector2(clamp(-499.0f, p.x, 499.0f), clamp(-499.0f, p.y, 499.0f));
+		}
+	}
+
+	double t0 = Clock::getTime();
+	for(int f = 1; f < NUM_FRAMES; f++) {
+		for(int i = 0; i < NUM_ENTITIES; i++) {
+			grid.update(ids[i], frames[f - 1][i], frames[f][i]);
+		}
+	}
+
+	double t1 = Clock::getTime();
+	for(int f = 1; f < NUM_FRAMES; f++) {
+		flat.rebuild(ids, frames[f]);
+	}
+
+	double t2 = Clock::getTime();
+	for(int f = 1; f < NUM_FRAMES; f++) {
+		flat.rebuild(ids, frames[f], 4);
+	}
+
+	double t3 = Clock::getTime();
+
+	printf("CellSpacePartition %d entities, %d frames: update %.3f s, rebuild %.3f s, 4 thread rebuild %.3f s\n",
+			NUM_ENTITIES, NUM_FRAMES - 1, t1 - t0, t2 - t1, t3 - t2);
+
+	return flat.size() == (unsigned int)NUM_ENTITIES ? 0 : 1;
+}
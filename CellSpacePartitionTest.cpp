@@ -0,0 +1,183 @@
+#include <stdlib.h>
+
+#include <algorithm>
+#include <thread>
+
+#include "CellSpacePartition.h"
+#include "FlatCellSpacePartition.h"
+#include "HierarchicalCellSpacePartition.h"
+#include "NearestTest.h"
+
+using namespace Common;
+
+static Vector2 getRandomPoint()
+{
+	return Vector2(rand() % 1000 - 500, rand() % 600 - 300);
+}
+
+int cellspacepartition_nearest(int argc, char** argv)
+{
+	for(int i = 0; i < 100; i++) {
+		CellSpacePartition<int> grid(1000, 600, 20, 12, 1000);
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			grid.add(j, positions[j]);
+		}
+
+		for(int k = 0; k < 20; k++) {
+			if(!checkNearest("CellSpacePartition", grid, positions, getRandomPoint(),
+						1 + rand() % 10, rand() % 100))
+				return 1;
+		}
+	}
+
+	printf("Successfully passed 100 tests.\n");
+	return 0;
+}
+
+int flatcellspacepartition(int argc, char** argv)
+{
+	FlatCellSpacePartition<int> grid(1000, 600, 20, 12);
+	for(int i = 0; i < 100; i++) {
+		int numPoints = 10 + rand() % 10 * 1000;
+		std::vector<int> ids;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			ids.push_back(j);
+			positions.push_back(getRandomPoint());
+		}
+
+		grid.rebuild(ids, positions, 1 + i % 4);
+		if(grid.size() != (unsigned int)numPoints) {
+			printf("FlatCellSpacePartition: size %d, expected %d\n", grid.size(), numPoints);
+			return 1;
+		}
+
+		for(int k = 0; k < 20; k++) {
+			if(!checkNearest("FlatCellSpacePartition", grid, positions, getRandomPoint(),
+						1 + rand() % 10, rand() % 100))
+				return 1;
+		}
+	}
+
+	printf("Successfully passed 100 tests.\n");
+	return 0;
+}
+
+static bool checkQueries(const CellSpacePartition<int>& grid, const std::vector<Vector2>& positions,
+		const std::vector<AABB>& areas)
+{
+	std::vector<int> res;
+	for(auto& area : areas) {
+		std::vector<int> expected;
+		for(unsigned int j = 0; j < positions.size(); j++) {
+			if(area.contains(positions[j]))
+				expected.push_back(j);
+		}
+
+		res.clear();
+		grid.query(area, res);
+		std::sort(res.begin(), res.end());
+		if(res != expected)
+			return false;
+	}
+	return true;
+}
+
+int cellspacepartition_query(int argc, char** argv)
+{
+	for(int i = 0; i < 20; i++) {
+		CellSpacePartition<int> grid(1000, 600, 20, 12);
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			grid.add(j, positions[j]);
+		}
+
+		// the legacy cursor no longer has a fixed result limit
+		int count = 0;
+		for(grid.queryBegin(Vector2(0, 0), 1000); !grid.queryEnd(); grid.queryNext())
+			count++;
+		if(count != numPoints) {
+			printf("CellSpacePartition: cursor query returned %d members, expected %d\n",
+					count, numPoints);
+			return 1;
+		}
+
+		std::vector<AABB> areas[4];
+		for(auto& a : areas) {
+			for(int k = 0; k < 50; k++)
+				a.push_back(AABB(getRandomPoint(), Vector2(rand() % 100, rand() % 100)));
+		}
+
+		bool ok[4];
+		std::thread workers[4];
+		for(int t = 0; t < 4; t++) {
+			workers[t] = std::thread([&, t] () { ok[t] = checkQueries(grid, positions, areas[t]); });
+		}
+		for(auto& w : workers)
+			w.join();
+
+		if(!ok[0] || !ok[1] || !ok[2] || !ok[3]) {
+			printf("CellSpacePartition: concurrent query returned wrong members\n");
+			return 1;
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
+
+int hierarchicalcellspacepartition(int argc, char** argv)
+{
+	for(int i = 0; i < 100; i++) {
+		HierarchicalCellSpacePartition<int> grid(1000, 600, 50, 30, 1 + i % 3, 2 + i % 3);
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			grid.add(j, positions[j]);
+		}
+
+		// move some, remove a few
+		for(int j = 0; j < numPoints; j += 2) {
+			Vector2 newpos = getRandomPoint();
+			grid.update(j, positions[j], newpos);
+			positions[j] = newpos;
+		}
+		std::vector<bool> removed(numPoints);
+		for(int j = 0; j < numPoints; j += 7) {
+			grid.remove(j, positions[j]);
+			removed[j] = true;
+		}
+
+		std::vector<int> ids;
+		for(int k = 0; k < 20; k++) {
+			Vector2 p = getRandomPoint();
+			if(!checkNearest("HierarchicalCellSpacePartition", grid, positions, p,
+						1 + rand() % 10, rand() % 300, removed))
+				return 1;
+
+			AABB area(p, Vector2(rand() % 300, rand() % 300));
+			std::vector<int> inArea;
+			for(int j = 0; j < numPoints; j++) {
+				if(!removed[j] && area.contains(positions[j]))
+					inArea.push_back(j);
+			}
+			ids.clear();
+			grid.query(area, ids);
+			std::sort(ids.begin(), ids.end());
+			if(ids != inArea) {
+				printf("HierarchicalCellSpacePartition: query returned %zu points, expected %zu\n",
+						ids.size(), inArea.size());
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 100 tests.\n");
+	return 0;
+}
@@ -0,0 +1,283 @@
+#include "DStarLite.h"
+
+#include <cassert>
+#include <climits>
+
+#include <algorithm>
+
+namespace Common {
+
+// leaves room for the heuristic and km in the keys
+const int DStarLite::INFINITE_COST = INT_MAX / 4;
+
+bool DStarLite::Key::operator<(const Key& rhs) const
+{
+	if(k1 != rhs.k1)
+		return k1 < rhs.k1;
+	return k2 < rhs.k2;
+}
+
+bool DStarLite::Key::operator!=(const Key& rhs) const
+{
+	return k1 != rhs.k1 || k2 != rhs.k2;
+}
+
+bool DStarLite::OpenNode::operator<(const OpenNode& rhs) const
+{
+	// std heaps are max-heaps
+	return rhs.key < key;
+}
+
+DStarLite::DStarLite(const GridAStar& grid, const Point2& start, const Point2& goal)
+	: mGrid(grid),
+	mStart(start),
+	mGoal(goal),
+	mLastStart(start),
+	mKm(0),
+	mNumOpen(0),
+	mExpansions(0)
+{
+	reset();
+}
+
+void DStarLite::setStart(const Point2& start)
+{
+	// keys computed so far stay lower bounds if km grows by the distance moved
+	mKm += mGrid.heuristic(mLastStart, start);
+	mLastStart = start;
+	mStart = start;
+}
+
+void DStarLite::setGoal(const Point2& goal)
+{
+	mGoal = goal;
+	reset();
+}
+
+const Point2& DStarLite::getStart() const
+{
+	return mStart;
+}
+
+const Point2& DStarLite::getGoal() const
+{
+	return mGoal;
+}
+
+void DStarLite::tileChanged(int x, int y)
+{
+	assert(x >= 0 && y >= 0 && x < int(mGrid.getWidth()) && y < int(mGrid.getHeight()));
+	// the moves to and from the tile, and the diagonal moves past its corners,
+	// all start from the tile or its neighbours
+	updateCell(cellIndex(Point2(x, y)));
+	for(int d = 0; d < 8; d++) {
+		int nx = x + GridAStar::MOVE_DX[d];
+		int ny = y + GridAStar::MOVE_DY[d];
+		if(nx >= 0 && ny >= 0 && nx < int(mGrid.getWidth()) && ny < int(mGrid.getHeight()))
+			updateCell(cellIndex(Point2(nx, ny)));
+	}
+}
+
+bool DStarLite::findPath(std::vector<Point2>& path)
+{
+	path.clear();
+	mExpansions = 0;
+	if(!mGrid.isPassable(mStart.x, mStart.y) || !mGrid.isPassable(mGoal.x, mGoal.y))
+		return false;
+
+	computeShortestPath();
+	int cell = cellIndex(mStart);
+	if(mCells[cell].g >= INFINITE_COST)
+		return false;
+
+	// follow the cheapest successors down to the goal
+	int goal = cellIndex(mGoal);
+	int succ[8];
+	int costs[8];
+	path.push_back(mStart);
+	while(cell != goal) {
+		int best = -1;
+		int bestCost = INFINITE_COST;
+		int num = successors(cell, succ, costs);
+		for(int i = 0; i < num; i++) {
+			int g = mCells[succ[i]].g;
+			if(g < INFINITE_COST && g + costs[i] < bestCost) {
+				best = succ[i];
+				bestCost = g + costs[i];
+			}
+		}
+		if(best == -1 || path.size() > mCells.size()) {
+			assert(0);
+			path.clear();
+			return false;
+		}
+		cell = best;
+		path.push_back(cellPoint(cell));
+	}
+	return true;
+}
+
+unsigned int DStarLite::getExpansions() const
+{
+	return mExpansions;
+}
+
+void DStarLite::reset()
+{
+	Cell c = { INFINITE_COST, INFINITE_COST, { 0, 0 }, false };
+	mCells.assign(mGrid.getWidth() * mGrid.getHeight(), c);
+	mOpen.clear();
+	mNumOpen = 0;
+	mKm = 0;
+	mLastStart = mStart;
+
+	int goal = cellIndex(mGoal);
+	mCells[goal].rhs = 0;
+	push(goal);
+}
+
+DStarLite::Key DStarLite::calculateKey(int cell) const
+{
+	const Cell& c = mCells[cell];
+	int k2 = std::min(c.g, c.rhs);
+	Key k = { k2 + mGrid.heuristic(mStart, cellPoint(cell)) + mKm, k2 };
+	return k;
+}
+
+void DStarLite::updateCell(int cell)
+{
+	Cell& c = mCells[cell];
+	if(cell != cellIndex(mGoal)) {
+		int succ[8];
+		int costs[8];
+		int num = successors(cell, succ, costs);
+		c.rhs = INFINITE_COST;
+		for(int i = 0; i < num; i++) {
+			int g = mCells[succ[i]].g;
+			if(g < INFINITE_COST)
+				c.rhs = std::min(c.rhs, g + costs[i]);
+		}
+	}
+
+	if(c.open) {
+		c.open = false;
+		mNumOpen--;
+	}
+	if(c.g != c.rhs)
+		push(cell);
+}
+
+void DStarLite::push(int cell)
+{
+	Cell& c = mCells[cell];
+	c.key = calculateKey(cell);
+	if(!c.open) {
+		c.open = true;
+		mNumOpen++;
+	}
+
+	// the stale nodes left by lazy removals would pile up otherwise
+	if(mOpen.size() > 2 * mNumOpen + 1024) {
+		mOpen.clear();
+		for(unsigned int i = 0; i < mCells.size(); i++) {
+			if(mCells[i].open && int(i) != cell) {
+				OpenNode n = { mCells[i].key, int(i) };
+				mOpen.push_back(n);
+			}
+		}
+		std::make_heap(mOpen.begin(), mOpen.end());
+	}
+
+	OpenNode n = { c.key, cell };
+	mOpen.push_back(n);
+	std::push_heap(mOpen.begin(), mOpen.end());
+}
+
+void DStarLite::discardStale()
+{
+	while(!mOpen.empty()) {
+		const OpenNode& top = mOpen.front();
+		const Cell& c = mCells[top.cell];
+		if(c.open && !(c.key != top.key))
+			break;
+		std::pop_heap(mOpen.begin(), mOpen.end());
+		mOpen.pop_back();
+	}
+}
+
+void DStarLite::computeShortestPath()
+{
+	int start = cellIndex(mStart);
+	int succ[8];
+	int costs[8];
+	while(1) {
+		discardStale();
+		if(mOpen.empty())
+			break;
+
+		const Cell& s = mCells[start];
+		Key top = mOpen.front().key;
+		if(!(top < calculateKey(start)) && s.rhs == s.g)
+			break;
+
+		int cell = mOpen.front().cell;
+		std::pop_heap(mOpen.begin(), mOpen.end());
+		mOpen.pop_back();
+
+		Cell& c = mCells[cell];
+		Key key = calculateKey(cell);
+		if(top < key) {
+			// km has grown since the cell was queued
+			c.key = key;
+			OpenNode n = { key, cell };
+			mOpen.push_back(n);
+			std::push_heap(mOpen.begin(), mOpen.end());
+			continue;
+		}
+
+		c.open = false;
+		mNumOpen--;
+		mExpansions++;
+		if(c.g > c.rhs) {
+			c.g = c.rhs;
+		} else {
+			c.g = INFINITE_COST;
+			updateCell(cell);
+		}
+
+		// moves are symmetric, so the successors are the predecessors as well
+		int num = successors(cell, succ, costs);
+		for(int i = 0; i < num; i++)
+			updateCell(succ[i]);
+	}
+}
+
+int DStarLite::successors(int cell, int* out, int* costs) const
+{
+	Point2 p = cellPoint(cell);
+	if(!mGrid.isPassable(p.x, p.y))
+		return 0;
+
+	int num = 0;
+	int dirs = mGrid.getNumMoves();
+	for(int d = 0; d < dirs; d++) {
+		if(!mGrid.canMove(p.x, p.y, d))
+			continue;
+		out[num] = cellIndex(Point2(p.x + GridAStar::MOVE_DX[d], p.y + GridAStar::MOVE_DY[d]));
+		costs[num] = GridAStar::moveCost(d);
+		num++;
+	}
+	return num;
+}
+
+int DStarLite::cellIndex(const Point2& p) const
+{
+	return p.y * mGrid.getWidth() + p.x;
+}
+
+Point2 DStarLite::cellPoint(int cell) const
+{
+	return Point2(cell % mGrid.getWidth(), cell / mGrid.getWidth());
+}
+
+}
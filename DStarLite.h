@@ -0,0 +1,73 @@
+#ifndef COMMON_DSTARLITE_H
+#define COMMON_DSTARLITE_H
+
+#include <vector>
+
+#include "GridAStar.h"
+
+namespace Common {
+
+// Incremental replanning (D* Lite) over the cells of a GridAStar. The
+// search runs from the goal towards the start and keeps its state between
+// calls, so that after tiles change, or after the start has moved along
+// the path, only the part of the search affected is redone. Moves and
+// costs are those of GridAStar.
+// The grid is not owned; after changing it call tileChanged().
+class DStarLite {
+	public:
+		DStarLite(const GridAStar& grid, const Point2& start, const Point2& goal);
+		// the agent has moved, usually along the path
+		void setStart(const Point2& start);
+		// a new goal discards the search state
+		void setGoal(const Point2& goal);
+		const Point2& getStart() const;
+		const Point2& getGoal() const;
+		void tileChanged(int x, int y);
+		// shortest path from start to goal, both included, in path - false
+		// and an empty path if there is none
+		bool findPath(std::vector<Point2>& path);
+		unsigned int getExpansions() const; // by the last findPath()
+
+	private:
+		struct Key {
+			int k1;
+			int k2;
+			bool operator<(const Key& rhs) const;
+			bool operator!=(const Key& rhs) const;
+		};
+		struct Cell {
+			int g;
+			int rhs;
+			Key key; // valid if open
+			bool open;
+		};
+		struct OpenNode {
+			Key key;
+			int cell;
+			bool operator<(const OpenNode& rhs) const;
+		};
+		void reset();
+		Key calculateKey(int cell) const;
+		void updateCell(int cell);
+		void push(int cell);
+		void discardStale(); // pops the removed or outdated nodes off the top
+		void computeShortestPath();
+		int successors(int cell, int* out, int* costs) const;
+		int cellIndex(const Point2& p) const;
+		Point2 cellPoint(int cell) const;
+		static const int INFINITE_COST;
+
+		const GridAStar& mGrid;
+		Point2 mStart;
+		Point2 mGoal;
+		Point2 mLastStart; // where the start was when km was last changed
+		int mKm;
+		std::vector<Cell> mCells;
+		std::vector<OpenNode> mOpen; // binary heap, removals are lazy
+		unsigned int mNumOpen;
+		unsigned int mExpansions;
+};
+
+}
+
+#endif
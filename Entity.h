@@ -19,6 +19,7 @@ class Entity {
 		inline void setAcceleration(const Vector3& v);
 		inline const Vector3& getPosition() const;
 		inline const Vector3& getVelocity() const;
+		inline const Vector3& getAcceleration() const;
 		inline void setXYRotation(float r);
 		inline void addXYRotation(float r);
 		inline float getXYRotation() const;
@@ -102,6 +103,11 @@ const Vector3& Entity::getVelocity() const
 	return mVelocity;
 }
 
+const Vector3& Entity::getAcceleration() const
+{
+	return mAcceleration;
+}
+
 void Entity::setXYRotation(float r)
 {
 	mRotation = 0.0f;
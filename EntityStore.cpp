@@ -0,0 +1,129 @@
+#include "EntityStore.h"
+
+#include <cassert>
+
+#include <algorithm>
+
+#include "VectorMath.h"
+
+namespace Common {
+
+EntityHandle EntityStore::create()
+{
+	unsigned int slot;
+	if(mFreeSlots.empty()) {
+		slot = mSlots.size();
+		mSlots.push_back(Slot());
+		mSlots.back().generation = 0;
+	} else {
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+
+	unsigned int i = size();
+	mSlots[slot].index = i;
+	mSlotOf.push_back(slot);
+	position.push_back(Vector3());
+	velocity.push_back(Vector3());
+	acceleration.push_back(Vector3());
+	rotation.push_back(0.0f);
+	rotationalVelocity.push_back(0.0f);
+	rotationalAcceleration.push_back(0.0f);
+
+	EntityHandle h;
+	h.slot = slot;
+	h.generation = mSlots[slot].generation;
+	return h;
+}
+
+EntityHandle EntityStore::create(const Entity& e)
+{
+	EntityHandle h = create();
+	unsigned int i = indexOf(h);
+	position[i] = e.getPosition();
+	velocity[i] = e.getVelocity();
+	acceleration[i] = e.getAcceleration();
+	rotation[i] = e.getXYRotation();
+	rotationalVelocity[i] = e.getXYRotationalVelocity();
+	rotationalAcceleration[i] = e.getXYRotationalAcceleration();
+	return h;
+}
+
+void EntityStore::destroy(EntityHandle h)
+{
+	unsigned int i = indexOf(h);
+	unsigned int last = size() - 1;
+	if(i != last) {
+		position[i] = position[last];
+		velocity[i] = velocity[last];
+		acceleration[i] = acceleration[last];
+		rotation[i] = rotation[last];
+		rotationalVelocity[i] = rotationalVelocity[last];
+		rotationalAcceleration[i] = rotationalAcceleration[last];
+		mSlotOf[i] = mSlotOf[last];
+		mSlots[mSlotOf[i]].index = i;
+	}
+	position.pop_back();
+	velocity.pop_back();
+	acceleration.pop_back();
+	rotation.pop_back();
+	rotationalVelocity.pop_back();
+	rotationalAcceleration.pop_back();
+	mSlotOf.pop_back();
+
+	mSlots[h.slot].generation++;
+	mFreeSlots.push_back(h.slot);
+}
+
+bool EntityStore::valid(EntityHandle h) const
+{
+	return h.slot < mSlots.size() && mSlots[h.slot].generation == h.generation;
+}
+
+unsigned int EntityStore::size() const
+{
+	return mSlotOf.size();
+}
+
+void EntityStore::clear()
+{
+	while(size())
+		destroy(handleAt(size() - 1));
+}
+
+EntityStore::View EntityStore::get(EntityHandle h)
+{
+	assert(valid(h));
+	return View(*this, h);
+}
+
+unsigned int EntityStore::indexOf(EntityHandle h) const
+{
+	assert(valid(h));
+	return mSlots[h.slot].index;
+}
+
+EntityHandle EntityStore::handleAt(unsigned int i) const
+{
+	assert(i < size());
+	EntityHandle h;
+	h.slot = mSlotOf[i];
+	h.generation = mSlots[h.slot].generation;
+	return h;
+}
+
+void EntityStore::update(float time)
+{
+	// the same operations as Entity::update(), so the results are identical
+	unsigned int n = size();
+	VectorMath::addScaled(velocity.data(), acceleration.data(), time, velocity.data(), n);
+	VectorMath::addScaled(position.data(), velocity.data(), time, position.data(), n);
+	std::fill(acceleration.begin(), acceleration.end(), Vector3());
+	for(unsigned int i = 0; i < n; i++) {
+		rotationalVelocity[i] += rotationalAcceleration[i] * time;
+		rotation[i] += rotationalVelocity[i] * time;
+		rotationalAcceleration[i] = 0.0f;
+	}
+}
+
+}
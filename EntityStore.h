@@ -0,0 +1,232 @@
+#ifndef COMMON_ENTITYSTORE_H
+#define COMMON_ENTITYSTORE_H
+
+#include <vector>
+
+#include "Entity.h"
+
+namespace Common {
+
+// Refers to an entity of an EntityStore for as long as it exists; a handle
+// to a destroyed entity is never valid again.
+struct EntityHandle {
+	unsigned int slot;
+	unsigned int generation;
+	bool operator==(const EntityHandle& rhs) const { return slot == rhs.slot && generation == rhs.generation; }
+	bool operator!=(const EntityHandle& rhs) const { return !(*this == rhs); }
+};
+
+// The state of Entity kept as dense component arrays rather than as
+// separate objects. update() integrates all entities like Entity::update()
+// in one linear pass without virtual calls. Destroying an entity moves
+// the last one into its place, so the array indices change but the
+// handles don't.
+class EntityStore {
+	public:
+		// the accessors of Entity for one entity of the store
+		class View {
+			public:
+				inline View(EntityStore& store, EntityHandle h);
+				inline EntityHandle getHandle() const;
+				inline void move(const Vector3& v);
+				inline void setVelocity(const Vector3& v);
+				inline void addVelocity(const Vector3& v);
+				inline void setPosition(const Vector3& v);
+				inline void setAcceleration(const Vector3& v);
+				inline const Vector3& getPosition() const;
+				inline const Vector3& getVelocity() const;
+				inline const Vector3& getAcceleration() const;
+				inline void setXYRotation(float r);
+				inline void addXYRotation(float r);
+				inline float getXYRotation() const;
+				inline void setXYRotationalVelocity(float r);
+				inline void addXYRotationalVelocity(float r);
+				inline float getXYRotationalVelocity() const;
+				inline void setXYRotationalAcceleration(float r);
+				inline void addXYRotationalAcceleration(float r);
+				inline float getXYRotationalAcceleration() const;
+				inline float getSpeed() const;
+				inline void setAutomaticHeading();
+				inline void setVelocityToHeading();
+				inline void setVelocityToNegativeHeading();
+				inline Vector3 getHeadingVector() const;
+
+			private:
+				inline unsigned int index() const;
+				EntityStore& mStore;
+				EntityHandle mHandle;
+		};
+
+		EntityHandle create();
+		EntityHandle create(const Entity& e); // with the state of e
+		void destroy(EntityHandle h);
+		bool valid(EntityHandle h) const;
+		unsigned int size() const;
+		void clear();
+		View get(EntityHandle h);
+		unsigned int indexOf(EntityHandle h) const;
+		EntityHandle handleAt(unsigned int i) const;
+		void update(float time);
+
+		// indexed by indexOf()
+		std::vector<Vector3> position;
+		std::vector<Vector3> velocity;
+		std::vector<Vector3> acceleration;
+		std::vector<float> rotation;
+		std::vector<float> rotationalVelocity;
+		std::vector<float> rotationalAcceleration;
+
+	private:
+		struct Slot {
+			unsigned int index;
+			unsigned int generation;
+		};
+		std::vector<Slot> mSlots;
+		std::vector<unsigned int> mFreeSlots;
+		std::vector<unsigned int> mSlotOf; // of each index
+};
+
+EntityStore::View::View(EntityStore& store, EntityHandle h)
+	: mStore(store),
+	mHandle(h)
+{
+}
+
+EntityHandle EntityStore::View::getHandle() const
+{
+	return mHandle;
+}
+
+unsigned int EntityStore::View::index() const
+{
+	return mStore.indexOf(mHandle);
+}
+
+void EntityStore::View::move(const Vector3& v)
+{
+	mStore.position[index()] += v;
+}
+
+void EntityStore::View::setVelocity(const Vector3& v)
+{
+	mStore.velocity[index()] = v;
+}
+
+void EntityStore::View::addVelocity(const Vector3& v)
+{
+	mStore.velocity[index()] += v;
+}
+
+void EntityStore::View::setPosition(const Vector3& v)
+{
+	mStore.position[index()] = v;
+}
+
+void EntityStore::View::setAcceleration(const Vector3& v)
+{
+	mStore.acceleration[index()] = v;
+}
+
+const Vector3& EntityStore::View::getPosition() const
+{
+	return mStore.position[index()];
+}
+
+const Vector3& EntityStore::View::getVelocity() const
+{
+	return mStore.velocity[index()];
+}
+
+const Vector3& EntityStore::View::getAcceleration() const
+{
+	return mStore.acceleration[index()];
+}
+
+void EntityStore::View::setXYRotation(float r)
+{
+	mStore.rotation[index()] = 0.0f;
+	addXYRotation(r);
+}
+
+void EntityStore::View::addXYRotation(float r)
+{
+	float& rot = mStore.rotation[index()];
+	rot += r;
+	if(rot >= PI) {
+		rot = std::fmod(rot + PI, TWO_PI) - PI;
+	}
+	else if(rot < -PI) {
+		rot = std::fmod(rot - PI, TWO_PI) + PI;
+	}
+}
+
+float EntityStore::View::getXYRotation() const
+{
+	return mStore.rotation[index()];
+}
+
+void EntityStore::View::setXYRotationalVelocity(float r)
+{
+	mStore.rotationalVelocity[index()] = r;
+}
+
+void EntityStore::View::addXYRotationalVelocity(float r)
+{
+	mStore.rotationalVelocity[index()] += r;
+}
+
+float EntityStore::View::getXYRotationalVelocity() const
+{
+	return mStore.rotationalVelocity[index()];
+}
+
+void EntityStore::View::setXYRotationalAcceleration(float r)
+{
+	mStore.rotationalAcceleration[index()] = r;
+}
+
+void EntityStore::View::addXYRotationalAcceleration(float r)
+{
+	mStore.rotationalAcceleration[index()] += r;
+}
+
+float EntityStore::View::getXYRotationalAcceleration() const
+{
+	return mStore.rotationalAcceleration[index()];
+}
+
+float EntityStore::View::getSpeed() const
+{
+	return getVelocity().length();
+}
+
+void EntityStore::View::setAutomaticHeading()
+{
+	const Vector3& v = getVelocity();
+	if(v.null()) {
+		return;
+	}
+	mStore.rotation[index()] = atan2(v.y, v.x);
+}
+
+void EntityStore::View::setVelocityToHeading()
+{
+	float s = getSpeed();
+	setVelocity(getHeadingVector() * s);
+}
+
+void EntityStore::View::setVelocityToNegativeHeading()
+{
+	float s = getSpeed();
+	setVelocity(getHeadingVector() * -s);
+}
+
+Vector3 EntityStore::View::getHeadingVector() const
+{
+	float r = getXYRotation();
+	return Vector3(cos(r), sin(r), 0.0f);
+}
+
+}
+
+#endif
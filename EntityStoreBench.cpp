@@ -0,0 +1,68 @@
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "Clock.h"
+#include "EntityStore.h"
+
+using namespace Common;
+
+static const unsigned int NUM_ENTITIES = 50000;
+static const int NUM_FRAMES = 200;
+
+static Vector3 getRandomVector()
+{
+	return Vector3(rand() % 1000 - 500, rand() % 1000 - 500, 0);
+}
+
+int entitystore_update(int argc, char** argv)
+{
+	// separate objects in no particular order in memory, as a game
+	// creating and destroying them over time would have
+	std::vector<Entity*> entities;
+	EntityStore store;
+	for(unsigned int i = 0; i < NUM_ENTITIES; i++) {
+		Entity* e = new Entity();
+		e->setPosition(getRandomVector());
+		e->setVelocity(getRandomVector());
+		e->setXYRotationalVelocity(rand() % 10 / 10.0f);
+		entities.push_back(e);
+		store.create(*e);
+	}
+	std::vector<Entity*> shuffled(entities);
+	std::random_shuffle(shuffled.begin(), shuffled.end());
+
+	double t0 = Clock::getTime();
+	for(int f = 0; f < NUM_FRAMES; f++) {
+		for(auto e : shuffled) {
+			e->setAcceleration(Vector3(1.0f, 0.0f, 0.0f));
+			e->update(0.01f);
+		}
+	}
+
+	double t1 = Clock::getTime();
+	for(int f = 0; f < NUM_FRAMES; f++) {
+		for(auto& a : store.acceleration)
+			a = Vector3(1.0f, 0.0f, 0.0f);
+		store.update(0.01f);
+	}
+
+	double t2 = Clock::getTime();
+
+	printf("Entity update, %d entities, %d frames: objects %.3f s, store %.3f s\n",
+			NUM_ENTITIES, NUM_FRAMES, t1 - t0, t2 - t1);
+
+	bool ok = true;
+	for(unsigned int i = 0; i < NUM_ENTITIES; i++) {
+		if(!(entities[i]->getPosition() == store.position[i]) ||
+				entities[i]->getXYRotation() != store.rotation[i])
+			ok = false;
+		delete entities[i];
+	}
+
+	if(!ok) {
+		printf("Entity store: results differ\n");
+		return 1;
+	}
+	return 0;
+}
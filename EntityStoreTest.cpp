@@ -0,0 +1,100 @@
+#include <stdlib.h>
+
+#include <map>
+
+#include "EntityStore.h"
+
+using namespace Common;
+
+static Vector3 getRandomVector()
+{
+	return Vector3(rand() % 2000 / 10.0f - 100, rand() % 2000 / 10.0f - 100, rand() % 20 / 10.0f);
+}
+
+static bool same(const Entity& e, EntityStore::View v)
+{
+	return e.getPosition() == v.getPosition() &&
+		e.getVelocity() == v.getVelocity() &&
+		e.getAcceleration() == v.getAcceleration() &&
+		e.getXYRotation() == v.getXYRotation() &&
+		e.getXYRotationalVelocity() == v.getXYRotationalVelocity() &&
+		e.getXYRotationalAcceleration() == v.getXYRotationalAcceleration();
+}
+
+int entitystore_update(int argc, char** argv)
+{
+	for(int i = 0; i < 20; i++) {
+		EntityStore store;
+		// the same entities as separate objects
+		std::map<unsigned int, std::pair<EntityHandle, Entity>> entities;
+		std::vector<EntityHandle> destroyed;
+		unsigned int next = 0;
+		for(int step = 0; step < 100; step++) {
+			int op = rand() % 10;
+			if(op < 4 || entities.empty()) {
+				Entity e;
+				e.setPosition(getRandomVector());
+				e.setVelocity(getRandomVector());
+				e.setXYRotation(rand() % 60 / 10.0f - 3.0f);
+				EntityHandle h;
+				if(rand() % 2) {
+					h = store.create(e);
+				} else {
+					h = store.create();
+					if(!same(Entity(), store.get(h))) {
+						printf("EntityStore: new entity not initialised\n");
+						return 1;
+					}
+					store.get(h).setPosition(e.getPosition());
+					store.get(h).setVelocity(e.getVelocity());
+					store.get(h).setXYRotation(e.getXYRotation());
+				}
+				entities[next++] = std::make_pair(h, e);
+			} else if(op < 6) {
+				auto it = entities.begin();
+				std::advance(it, rand() % entities.size());
+				store.destroy(it->second.first);
+				destroyed.push_back(it->second.first);
+				entities.erase(it);
+			} else if(op < 8) {
+				for(auto& it : entities) {
+					Vector3 acc = getRandomVector();
+					float racc = rand() % 10 / 10.0f - 0.5f;
+					it.second.second.setAcceleration(acc);
+					it.second.second.setXYRotationalAcceleration(racc);
+					store.get(it.second.first).setAcceleration(acc);
+					store.get(it.second.first).setXYRotationalAcceleration(racc);
+				}
+			} else {
+				for(auto& it : entities)
+					it.second.second.update(0.1f);
+				store.update(0.1f);
+			}
+
+			if(store.size() != entities.size()) {
+				printf("EntityStore: %d entities, expected %d\n", store.size(), int(entities.size()));
+				return 1;
+			}
+			for(auto& it : entities) {
+				EntityHandle h = it.second.first;
+				if(!store.valid(h) || store.handleAt(store.indexOf(h)) != h) {
+					printf("EntityStore: handle lost\n");
+					return 1;
+				}
+				if(!same(it.second.second, store.get(h))) {
+					printf("EntityStore: entity %d differs from Entity\n", it.first);
+					return 1;
+				}
+			}
+			for(auto h : destroyed) {
+				if(store.valid(h)) {
+					printf("EntityStore: destroyed handle still valid\n");
+					return 1;
+				}
+			}
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
@@ -0,0 +1,283 @@
+#ifndef COMMON_FLATCELLSPACEPARTITION_H
+#define COMMON_FLATCELLSPACEPARTITION_H
+
+#include <vector>
+#include <thread>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include "Math.h"
+#include "Vector2.h"
+#include "Partition.h"
+
+namespace Common {
+
+// Alternative to CellSpacePartition for populations where most entities
+// move every frame. Instead of updating entities one by one, the whole
+// grid is rebuilt with a counting sort of the entities by cell. The
+// members of cell c are then entities[cellStart[c] .. cellStart[c + 1]),
+// with their positions in the same slots of a parallel array.
+// Positions outside the grid are clamped to the edge cells, though
+// distance queries assume all entities are within the grid.
+template<class T>
+class FlatCellSpacePartition {
+	public:
+		inline FlatCellSpacePartition(float w, float h,
+				unsigned int cellsx, unsigned int cellsy);
+		// replaces the contents in O(N)
+		inline void rebuild(const std::vector<T>& entities, const std::vector<Vector2>& positions,
+				unsigned int threads = 1);
+		inline void clear();
+		inline unsigned int size() const;
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const; // calls visitor(const T&, const Vector2&)
+		// k nearest entities to p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		// entities within radius of p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const;
+
+	private:
+		inline unsigned int positionToIndex(const Vector2& p) const;
+		inline void positionToCell(const Vector2& p, int& i, int& j) const;
+		inline AABB cellBox(int i, int j) const;
+		inline void countCells(const std::vector<Vector2>& positions,
+				unsigned int begin, unsigned int end, unsigned int* counts);
+		inline void scatter(const std::vector<T>& entities, const std::vector<Vector2>& positions,
+				unsigned int begin, unsigned int end, unsigned int* cursors);
+		static const unsigned int PARALLEL_REBUILD_MIN = 4096;
+		float mWidth;
+		float mHeight;
+
+		unsigned int mNumCellsX;
+		unsigned int mNumCellsY;
+
+		float mCellWidth;
+		float mCellHeight;
+
+		std::vector<unsigned int> mCellStart; // one past the cell count long
+		std::vector<T> mEntities;
+		std::vector<Vector2> mPositions;
+
+		// rebuild scratch, kept around to avoid reallocating every frame
+		std::vector<unsigned int> mCellOf;
+		std::vector<unsigned int> mCounts;
+};
+
+template<class T>
+FlatCellSpacePartition<T>::FlatCellSpacePartition(float w, float h, unsigned int cellsx, unsigned int cellsy)
+	: mWidth(w),
+	mHeight(h),
+	mNumCellsX(cellsx),
+	mNumCellsY(cellsy)
+{
+	mCellWidth  = ceil(mWidth  / (float)mNumCellsX);
+	mCellHeight = ceil(mHeight / (float)mNumCellsY);
+	mCellStart.resize(mNumCellsX * mNumCellsY + 1);
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::rebuild(const std::vector<T>& entities, const std::vector<Vector2>& positions,
+		unsigned int threads)
+{
+	assert(entities.size() == positions.size());
+	unsigned int num = entities.size();
+	unsigned int numCells = mNumCellsX * mNumCellsY;
+
+	if(num < PARALLEL_REBUILD_MIN)
+		threads = 1;
+	threads = std::max(1u, threads);
+
+	mCellOf.resize(num);
+	mEntities.resize(num);
+	mPositions.resize(num);
+
+	// per thread histograms, stored cell-major so that a single prefix sum
+	// gives each thread its own write cursor within every cell
+	mCounts.assign(numCells * threads, 0);
+	unsigned int chunk = (num + threads - 1) / threads;
+
+	if(threads == 1) {
+		countCells(positions, 0, num, &mCounts[0]);
+	} else {
+		std::vector<std::thread> workers;
+		for(unsigned int t = 0; t < threads; t++) {
+			workers.push_back(std::thread(&FlatCellSpacePartition<T>::countCells, this,
+						std::cref(positions), std::min(num, t * chunk),
+						std::min(num, (t + 1) * chunk), &mCounts[t * numCells]));
+		}
+		for(auto& w : workers)
+			w.join();
+	}
+
+	unsigned int total = 0;
+	for(unsigned int c = 0; c < numCells; c++) {
+		mCellStart[c] = total;
+		for(unsigned int t = 0; t < threads; t++) {
+			unsigned int n = mCounts[t * numCells + c];
+			mCounts[t * numCells + c] = total;
+			total += n;
+		}
+	}
+	mCellStart[numCells] = total;
+	assert(total == num);
+
+	if(threads == 1) {
+		scatter(entities, positions, 0, num, &mCounts[0]);
+	} else {
+		std::vector<std::thread> workers;
+		for(unsigned int t = 0; t < threads; t++) {
+			workers.push_back(std::thread(&FlatCellSpacePartition<T>::scatter, this,
+						std::cref(entities), std::cref(positions), std::min(num, t * chunk),
+						std::min(num, (t + 1) * chunk), &mCounts[t * numCells]));
+		}
+		for(auto& w : workers)
+			w.join();
+	}
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::countCells(const std::vector<Vector2>& positions,
+		unsigned int begin, unsigned int end, unsigned int* counts)
+{
+	for(unsigned int i = begin; i < end; i++) {
+		unsigned int c = positionToIndex(positions[i]);
+		mCellOf[i] = c;
+		counts[c]++;
+	}
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::scatter(const std::vector<T>& entities, const std::vector<Vector2>& positions,
+		unsigned int begin, unsigned int end, unsigned int* cursors)
+{
+	for(unsigned int i = begin; i < end; i++) {
+		unsigned int dst = cursors[mCellOf[i]]++;
+		mEntities[dst] = entities[i];
+		mPositions[dst] = positions[i];
+	}
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::clear()
+{
+	std::fill(mCellStart.begin(), mCellStart.end(), 0);
+	mEntities.clear();
+	mPositions.clear();
+}
+
+template<class T>
+unsigned int FlatCellSpacePartition<T>::size() const
+{
+	return mEntities.size();
+}
+
+template<class T>
+template<typename F>
+void FlatCellSpacePartition<T>::query(const AABB& area, F&& visitor) const
+{
+	int minx, miny, maxx, maxy;
+	positionToCell(area.center - area.halfDimension, minx, miny);
+	positionToCell(area.center + area.halfDimension, maxx, maxy);
+
+	for(int j = miny; j <= maxy; j++) {
+		// cells of a row are adjacent, so the whole span is one slice
+		unsigned int begin = mCellStart[j * mNumCellsX + minx];
+		unsigned int end = mCellStart[j * mNumCellsX + maxx + 1];
+		for(unsigned int k = begin; k < end; k++) {
+			if(area.contains(mPositions[k])) {
+				visitor(mEntities[k], mPositions[k]);
+			}
+		}
+	}
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	if(k == 0)
+		return;
+
+	int ci, cj;
+	positionToCell(p, ci, cj);
+
+	// visit rings of cells around p until the next ring is too far away
+	float cellSize = std::min(mCellWidth, mCellHeight);
+	int maxRing = std::max(mNumCellsX, mNumCellsY);
+	for(int r = 0; r <= maxRing; r++) {
+		float ringDist = (r - 1) * cellSize;
+		if(r > 1 && ringDist * ringDist > nearestBound(out, k))
+			break;
+
+		for(int j = cj - r; j <= cj + r; j++) {
+			if(j < 0 || j >= int(mNumCellsY))
+				continue;
+
+			bool edgeRow = j == cj - r || j == cj + r;
+			int step = edgeRow || r == 0 ? 1 : 2 * r;
+			for(int i = ci - r; i <= ci + r; i += step) {
+				if(i < 0 || i >= int(mNumCellsX))
+					continue;
+
+				unsigned int c = j * mNumCellsX + i;
+				if(mCellStart[c] == mCellStart[c + 1] ||
+						cellBox(i, j).distance2(p) > nearestBound(out, k))
+					continue;
+
+				for(unsigned int m = mCellStart[c]; m < mCellStart[c + 1]; m++) {
+					pushNearest(out, k, p.distance2(mPositions[m]), mEntities[m]);
+				}
+			}
+		}
+	}
+
+	std::sort_heap(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+
+	float radius2 = radius * radius;
+	query(AABB(p, Vector2(radius, radius)), [&] (const T& t, const Vector2& pos) {
+			float d2 = p.distance2(pos);
+			if(d2 <= radius2)
+				out.push_back(std::make_pair(d2, t));
+			});
+
+	std::sort(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+unsigned int FlatCellSpacePartition<T>::positionToIndex(const Vector2& p) const
+{
+	int i, j;
+	positionToCell(p, i, j);
+	return j * mNumCellsX + i;
+}
+
+template<class T>
+void FlatCellSpacePartition<T>::positionToCell(const Vector2& p, int& i, int& j) const
+{
+	// clamped to the grid
+	i = clamp<int>(0, floor((p.x + mWidth * 0.5f) / mCellWidth), mNumCellsX - 1);
+	j = clamp<int>(0, floor((p.y + mHeight * 0.5f) / mCellHeight), mNumCellsY - 1);
+}
+
+template<class T>
+AABB FlatCellSpacePartition<T>::cellBox(int i, int j) const
+{
+	return AABB(Vector2((i + 0.5f) * mCellWidth - mWidth * 0.5f,
+				(j + 0.5f) * mCellHeight - mHeight * 0.5f),
+			Vector2(mCellWidth * 0.5f, mCellHeight * 0.5f));
+}
+
+}
+
+#endif
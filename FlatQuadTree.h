@@ -0,0 +1,18 @@
+#ifndef COMMON_FLATQUADTREE_H
+#define COMMON_FLATQUADTREE_H
+
+#include "PointTree.h"
+
+namespace Common {
+
+// Drop-in alternative to QuadTree that keeps all nodes in one array, see
+// PointTree for the layout.
+template<class T>
+using FlatQuadTree = PointTree<T, AABB, 4>;
+
+template<class T>
+using FQTIterator = PointTreeIterator<T, AABB, 4>;
+
+}
+
+#endif
@@ -0,0 +1,123 @@
+#include "Flock.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+
+namespace Common {
+
+// cells the size of the radius, so that a query visits at most 3 x 3 cells
+static unsigned int cellsFor(float size, float radius)
+{
+	return std::max(1u, (unsigned int)(size / radius));
+}
+
+Flock::Flock(float w, float h, float radius)
+	: mRadius(radius),
+	mSeparationWeight(1.0f),
+	mCohesionWeight(1.0f),
+	mAlignmentWeight(1.0f),
+	mPartition(w, h, cellsFor(w, radius), cellsFor(h, radius))
+{
+	assert(radius > 0.0f);
+}
+
+void Flock::setWeights(float separation, float cohesion, float alignment)
+{
+	mSeparationWeight = separation;
+	mCohesionWeight = cohesion;
+	mAlignmentWeight = alignment;
+}
+
+float Flock::getRadius() const
+{
+	return mRadius;
+}
+
+void Flock::update(const SteeringBatch& vehicles, Vector3Array& out, unsigned int threads)
+{
+	unsigned int n = vehicles.size();
+	const Vector3Array& pos = vehicles.position;
+	const Vector3Array& vel = vehicles.velocity;
+	mIndices.resize(n);
+	mPositions.resize(n);
+	for(unsigned int i = 0; i < n; i++) {
+		mIndices[i] = i;
+		mPositions[i] = Vector2(pos.x[i], pos.y[i]);
+	}
+	mPartition.rebuild(mIndices, mPositions, threads);
+
+	out.resize(n);
+	float radius2 = mRadius * mRadius;
+	for(unsigned int i = 0; i < n; i++) {
+		float px = pos.x[i], py = pos.y[i], pz = pos.z[i];
+		float sx = 0.0f, sy = 0.0f, sz = 0.0f;
+		float cx = 0.0f, cy = 0.0f, cz = 0.0f;
+		float ax = 0.0f, ay = 0.0f, az = 0.0f;
+		int count = 0;
+		mPartition.query(AABB(mPositions[i], Vector2(mRadius, mRadius)),
+				[&] (const unsigned int& k, const Vector2&) {
+				if(k == i)
+					return;
+				float dx = px - pos.x[k];
+				float dy = py - pos.y[k];
+				float dz = pz - pos.z[k];
+				float dist2 = dx * dx + dy * dy + dz * dz;
+				if(dist2 > radius2)
+					return;
+				// away from each neighbour, the harder the nearer it is
+				if(dist2 > 0.0f) {
+					sx += dx / dist2;
+					sy += dy / dist2;
+					sz += dz / dist2;
+				}
+				cx += pos.x[k];
+				cy += pos.y[k];
+				cz += pos.z[k];
+				ax += vel.x[k];
+				ay += vel.y[k];
+				az += vel.z[k];
+				count++;
+				});
+
+		float fx = sx * mSeparationWeight;
+		float fy = sy * mSeparationWeight;
+		float fz = sz * mSeparationWeight;
+		if(count) {
+			float scale = 1.0f / count;
+			// seek the center of mass
+			float dx = cx * scale - px;
+			float dy = cy * scale - py;
+			float dz = cz * scale - pz;
+			float len = sqrtf(dx * dx + dy * dy + dz * dz);
+			float speed = len > 0.0f ? vehicles.maxSpeed[i] / len : 0.0f;
+			fx += (dx * speed - vel.x[i]) * mCohesionWeight;
+			fy += (dy * speed - vel.y[i]) * mCohesionWeight;
+			fz += (dz * speed - vel.z[i]) * mCohesionWeight;
+			// match the average velocity
+			fx += (ax * scale - vel.x[i]) * mAlignmentWeight;
+			fy += (ay * scale - vel.y[i]) * mAlignmentWeight;
+			fz += (az * scale - vel.z[i]) * mAlignmentWeight;
+		}
+		out.x[i] = fx;
+		out.y[i] = fy;
+		out.z[i] = fz;
+	}
+}
+
+void Flock::update(const std::vector<Vehicle*>& vehicles, std::vector<Vector3>& out,
+		unsigned int threads)
+{
+	unsigned int n = vehicles.size();
+	mBatch.resize(n);
+	for(unsigned int i = 0; i < n; i++)
+		mBatch.setVehicle(i, *vehicles[i]);
+
+	update(mBatch, mForces, threads);
+	out.resize(n);
+	for(unsigned int i = 0; i < n; i++)
+		out[i] = mForces.get(i);
+}
+
+}
@@ -0,0 +1,44 @@
+#ifndef COMMON_FLOCK_H
+#define COMMON_FLOCK_H
+
+#include <vector>
+
+#include "FlatCellSpacePartition.h"
+#include "SteeringBatch.h"
+
+namespace Common {
+
+// Separation, cohesion and alignment for a whole population, each vehicle
+// steered by the others within the neighbour radius. The vehicles are
+// sorted into a FlatCellSpacePartition covering w x h around the origin
+// every update, then the three behaviours are summed while visiting the
+// neighbours once, so that an update is O(N * k) for k neighbours on
+// average. Buffers are kept between updates and only grow.
+// The force of each vehicle is that of the weighted sum of
+// Steering::separation, cohesion and alignment with the neighbours
+// within the radius, within float precision.
+class Flock {
+	public:
+		Flock(float w, float h, float radius);
+		void setWeights(float separation, float cohesion, float alignment);
+		float getRadius() const;
+		// out is overwritten with one force per vehicle
+		void update(const SteeringBatch& vehicles, Vector3Array& out, unsigned int threads = 1);
+		void update(const std::vector<Vehicle*>& vehicles, std::vector<Vector3>& out,
+				unsigned int threads = 1);
+
+	private:
+		float mRadius;
+		float mSeparationWeight;
+		float mCohesionWeight;
+		float mAlignmentWeight;
+		FlatCellSpacePartition<unsigned int> mPartition;
+		std::vector<unsigned int> mIndices;
+		std::vector<Vector2> mPositions;
+		SteeringBatch mBatch;
+		Vector3Array mForces;
+};
+
+}
+
+#endif
@@ -0,0 +1,272 @@
+#include "FlowField.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+
+namespace Common {
+
+const unsigned char FlowField::NO_DIRECTION;
+
+static bool canMove(const FlowFieldMap& map, int x, int y, int d)
+{
+	return GridAStar::canMove([&] (int cx, int cy) { return map.getCost(cx, cy) != 0; }, x, y, d);
+}
+
+static int moveCost(const FlowFieldMap& map, int x, int y, int d)
+{
+	return map.getCost(x, y) * GridAStar::moveCost(d);
+}
+
+static bool cellAt(const Vector2& origin, float cellSize, unsigned int w, unsigned int h,
+		const Vector3& pos, Point2& cell)
+{
+	float x = floorf((pos.x - origin.x) / cellSize);
+	float y = floorf((pos.y - origin.y) / cellSize);
+	if(x < 0.0f || y < 0.0f || x >= w || y >= h)
+		return false;
+	cell = Point2(x, y);
+	return true;
+}
+
+bool FlowField::OpenNode::operator<(const OpenNode& rhs) const
+{
+	// std heaps are max-heaps
+	return distance > rhs.distance;
+}
+
+FlowField::FlowField(const FlowFieldMap& map, const Point2& goal)
+	: mWidth(map.getWidth()),
+	mHeight(map.getHeight()),
+	mCellSize(map.getCellSize()),
+	mOrigin(map.getOrigin()),
+	mGoal(goal)
+{
+	integrate(map);
+	buildDirections(map);
+}
+
+unsigned int FlowField::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned int FlowField::getHeight() const
+{
+	return mHeight;
+}
+
+const Point2& FlowField::getGoal() const
+{
+	return mGoal;
+}
+
+Vector3 FlowField::getGoalPosition() const
+{
+	return Vector3(mOrigin.x + (mGoal.x + 0.5f) * mCellSize,
+			mOrigin.y + (mGoal.y + 0.5f) * mCellSize, 0.0f);
+}
+
+bool FlowField::cellAt(const Vector3& pos, Point2& cell) const
+{
+	return Common::cellAt(mOrigin, mCellSize, mWidth, mHeight, pos, cell);
+}
+
+int FlowField::getDistance(int x, int y) const
+{
+	if(x < 0 || y < 0 || x >= int(mWidth) || y >= int(mHeight))
+		return -1;
+	return mDistance[y * mWidth + x];
+}
+
+Vector3 FlowField::getDirection(int x, int y) const
+{
+	static const float DIAG = 0.70710678f;
+	static const Vector3 DIRECTIONS[] = {
+		Vector3(1, 0, 0), Vector3(-1, 0, 0), Vector3(0, 1, 0), Vector3(0, -1, 0),
+		Vector3(DIAG, DIAG, 0), Vector3(DIAG, -DIAG, 0), Vector3(-DIAG, DIAG, 0), Vector3(-DIAG, -DIAG, 0),
+		Vector3()
+	};
+	if(x < 0 || y < 0 || x >= int(mWidth) || y >= int(mHeight))
+		return Vector3();
+	return DIRECTIONS[mDirection[y * mWidth + x]];
+}
+
+Vector3 FlowField::getDirection(const Vector3& pos) const
+{
+	Point2 cell;
+	if(!cellAt(pos, cell))
+		return Vector3();
+	return getDirection(cell.x, cell.y);
+}
+
+bool FlowField::getNext(const Point2& cell, Point2& next) const
+{
+	if(cell.x < 0 || cell.y < 0 || cell.x >= int(mWidth) || cell.y >= int(mHeight))
+		return false;
+	unsigned char d = mDirection[cell.y * mWidth + cell.x];
+	if(d == NO_DIRECTION)
+		return false;
+	next = Point2(cell.x + GridAStar::MOVE_DX[d], cell.y + GridAStar::MOVE_DY[d]);
+	return true;
+}
+
+void FlowField::integrate(const FlowFieldMap& map)
+{
+	// Dijkstra outwards from the goal
+	mDistance.assign(mWidth * mHeight, -1);
+	if(!map.getCost(mGoal.x, mGoal.y))
+		return;
+
+	std::vector<OpenNode> open;
+	int goal = mGoal.y * mWidth + mGoal.x;
+	mDistance[goal] = 0;
+	open.push_back({0, goal});
+	while(!open.empty()) {
+		std::pop_heap(open.begin(), open.end());
+		OpenNode n = open.back();
+		open.pop_back();
+		if(n.distance != mDistance[n.cell])
+			continue; // superseded
+
+		int x = n.cell % mWidth;
+		int y = n.cell / mWidth;
+		for(int d = 0; d < 8; d++) {
+			// moves are symmetric, so the neighbour can move here if this
+			// cell can move to the neighbour
+			if(!canMove(map, x, y, d))
+				continue;
+
+			int nx = x + GridAStar::MOVE_DX[d];
+			int ny = y + GridAStar::MOVE_DY[d];
+			int cell = ny * mWidth + nx;
+			int dist = n.distance + moveCost(map, nx, ny, d);
+			if(mDistance[cell] == -1 || dist < mDistance[cell]) {
+				mDistance[cell] = dist;
+				open.push_back({dist, cell});
+				std::push_heap(open.begin(), open.end());
+			}
+		}
+	}
+}
+
+void FlowField::buildDirections(const FlowFieldMap& map)
+{
+	mDirection.assign(mWidth * mHeight, NO_DIRECTION);
+	for(unsigned int y = 0; y < mHeight; y++) {
+		for(unsigned int x = 0; x < mWidth; x++) {
+			int dist = mDistance[y * mWidth + x];
+			if(dist <= 0)
+				continue;
+
+			// the first step of a cheapest path
+			for(int d = 0; d < 8; d++) {
+				if(canMove(map, x, y, d) &&
+						mDistance[(y + GridAStar::MOVE_DY[d]) * mWidth + x + GridAStar::MOVE_DX[d]] + moveCost(map, x, y, d) == dist) {
+					mDirection[y * mWidth + x] = d;
+					break;
+				}
+			}
+			assert(mDirection[y * mWidth + x] != NO_DIRECTION);
+		}
+	}
+}
+
+FlowFieldMap::FlowFieldMap(unsigned int width, unsigned int height, const std::vector<unsigned char>& costs,
+		float cellSize, const Vector2& origin, unsigned int maxFields)
+	: mWidth(width),
+	mHeight(height),
+	mCellSize(cellSize),
+	mOrigin(origin),
+	mMaxFields(maxFields),
+	mCosts(costs),
+	mUseCounter(0)
+{
+	assert(costs.size() == width * height);
+	assert(maxFields > 0);
+}
+
+unsigned int FlowFieldMap::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned int FlowFieldMap::getHeight() const
+{
+	return mHeight;
+}
+
+float FlowFieldMap::getCellSize() const
+{
+	return mCellSize;
+}
+
+const Vector2& FlowFieldMap::getOrigin() const
+{
+	return mOrigin;
+}
+
+unsigned char FlowFieldMap::getCost(int x, int y) const
+{
+	if(x < 0 || y < 0 || x >= int(mWidth) || y >= int(mHeight))
+		return 0;
+	return mCosts[y * mWidth + x];
+}
+
+void FlowFieldMap::setCost(int x, int y, unsigned char cost)
+{
+	assert(x >= 0 && y >= 0 && x < int(mWidth) && y < int(mHeight));
+	if(mCosts[y * mWidth + x] == cost)
+		return;
+	mCosts[y * mWidth + x] = cost;
+	invalidate();
+}
+
+bool FlowFieldMap::cellAt(const Vector3& pos, Point2& cell) const
+{
+	return Common::cellAt(mOrigin, mCellSize, mWidth, mHeight, pos, cell);
+}
+
+Vector3 FlowFieldMap::getCellCenter(const Point2& cell) const
+{
+	return Vector3(mOrigin.x + (cell.x + 0.5f) * mCellSize,
+			mOrigin.y + (cell.y + 0.5f) * mCellSize, 0.0f);
+}
+
+std::shared_ptr<const FlowField> FlowFieldMap::getField(const Point2& goal)
+{
+	assert(goal.x >= 0 && goal.y >= 0 && goal.x < int(mWidth) && goal.y < int(mHeight));
+	int key = goal.y * mWidth + goal.x;
+	auto it = mFields.find(key);
+	if(it != mFields.end()) {
+		it->second.lastUse = ++mUseCounter;
+		return it->second.field;
+	}
+
+	if(mFields.size() >= mMaxFields) {
+		auto oldest = mFields.begin();
+		for(auto it2 = mFields.begin(); it2 != mFields.end(); ++it2) {
+			if(it2->second.lastUse < oldest->second.lastUse)
+				oldest = it2;
+		}
+		mFields.erase(oldest);
+	}
+
+	CachedField& c = mFields[key];
+	c.field = std::shared_ptr<const FlowField>(new FlowField(*this, goal));
+	c.lastUse = ++mUseCounter;
+	return c.field;
+}
+
+void FlowFieldMap::invalidate()
+{
+	mFields.clear();
+}
+
+unsigned int FlowFieldMap::getNumFields() const
+{
+	return mFields.size();
+}
+
+}
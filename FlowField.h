@@ -0,0 +1,104 @@
+#ifndef COMMON_FLOWFIELD_H
+#define COMMON_FLOWFIELD_H
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "GridAStar.h"
+#include "Line.h"
+#include "Vector2.h"
+#include "Vector3.h"
+
+namespace Common {
+
+class FlowFieldMap;
+
+// The cost of the cheapest path from every cell to one goal cell, and the
+// direction of the first step of that path, so that any number of agents
+// heading for the same goal can look up where to go in constant time.
+// Moves are 8-connected without cutting corners and cost the cost of the
+// cell left times FlowFieldMap::ORTHOGONAL_COST or DIAGONAL_COST.
+class FlowField {
+	public:
+		unsigned int getWidth() const;
+		unsigned int getHeight() const;
+		const Point2& getGoal() const;
+		Vector3 getGoalPosition() const; // the center of the goal cell
+		// false if pos is outside the grid
+		bool cellAt(const Vector3& pos, Point2& cell) const;
+		// -1 if there is no path to the goal or the cell is outside the grid
+		int getDistance(int x, int y) const;
+		// unit vector, zero in the goal cell and where the goal can't be reached
+		Vector3 getDirection(int x, int y) const;
+		Vector3 getDirection(const Vector3& pos) const;
+		// the cell the direction points to, false if there is none
+		bool getNext(const Point2& cell, Point2& next) const;
+
+	private:
+		FlowField(const FlowFieldMap& map, const Point2& goal);
+		void integrate(const FlowFieldMap& map);
+		void buildDirections(const FlowFieldMap& map);
+		struct OpenNode {
+			int distance;
+			int cell;
+			bool operator<(const OpenNode& rhs) const;
+		};
+		static const unsigned char NO_DIRECTION = 8;
+
+		unsigned int mWidth;
+		unsigned int mHeight;
+		float mCellSize;
+		Vector2 mOrigin;
+		Point2 mGoal;
+		std::vector<int> mDistance; // row-major, -1 if unreachable
+		std::vector<unsigned char> mDirection; // index to the move tables or NO_DIRECTION
+
+		friend class FlowFieldMap;
+};
+
+// A cost grid placed in the world, and the flow fields towards the goal
+// cells asked for. Fields are built on first use and kept until the
+// costs change or more than maxFields other goals have been used since.
+class FlowFieldMap {
+	public:
+		// costs is row-major and width * height long, 0 for blocked cells;
+		// cell (0, 0) starts at origin
+		FlowFieldMap(unsigned int width, unsigned int height, const std::vector<unsigned char>& costs,
+				float cellSize = 1.0f, const Vector2& origin = Vector2(),
+				unsigned int maxFields = 16);
+		unsigned int getWidth() const;
+		unsigned int getHeight() const;
+		float getCellSize() const;
+		const Vector2& getOrigin() const;
+		unsigned char getCost(int x, int y) const; // 0 outside the grid
+		void setCost(int x, int y, unsigned char cost); // discards the fields
+		bool cellAt(const Vector3& pos, Point2& cell) const;
+		Vector3 getCellCenter(const Point2& cell) const;
+		// the field towards the goal cell, which stays valid for the holder
+		// even after the map discards it
+		std::shared_ptr<const FlowField> getField(const Point2& goal);
+		void invalidate();
+		unsigned int getNumFields() const; // currently cached
+
+		static const int ORTHOGONAL_COST = GridAStar::ORTHOGONAL_COST;
+		static const int DIAGONAL_COST = GridAStar::DIAGONAL_COST;
+
+	private:
+		struct CachedField {
+			std::shared_ptr<const FlowField> field;
+			unsigned int lastUse;
+		};
+		unsigned int mWidth;
+		unsigned int mHeight;
+		float mCellSize;
+		Vector2 mOrigin;
+		unsigned int mMaxFields;
+		std::vector<unsigned char> mCosts;
+		std::unordered_map<int, CachedField> mFields; // by goal cell index
+		unsigned int mUseCounter;
+};
+
+}
+
+#endif
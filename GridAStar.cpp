@@ -0,0 +1,429 @@
+#include "GridAStar.h"
+
+#include <cassert>
+#include <cstdlib>
+
+#include <algorithm>
+
+#include "Math.h"
+
+namespace Common {
+
+const int GridAStar::MOVE_DX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+const int GridAStar::MOVE_DY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+static const int* DX = GridAStar::MOVE_DX;
+static const int* DY = GridAStar::MOVE_DY;
+
+static int direction(int dx, int dy)
+{
+	for(int d = 0; d < 8; d++) {
+		if(DX[d] == dx && DY[d] == dy)
+			return d;
+	}
+	assert(0);
+	return -1;
+}
+
+GridAStar::Scratch::Scratch()
+	: mGeneration(0),
+	mExpansions(0)
+{
+}
+
+unsigned int GridAStar::Scratch::getExpansions() const
+{
+	return mExpansions;
+}
+
+bool GridAStar::Scratch::OpenNode::operator<(const OpenNode& rhs) const
+{
+	// std heaps are max-heaps: lowest f first, ties to the node nearer the goal
+	if(f != rhs.f)
+		return f > rhs.f;
+	return h > rhs.h;
+}
+
+void GridAStar::Scratch::prepare(unsigned int numCells)
+{
+	mOpen.clear();
+	mExpansions = 0;
+	mGeneration++;
+	if(mCells.size() != numCells || mGeneration == 0) {
+		Cell c = { 0, 0, 0, -1 };
+		mCells.assign(numCells, c);
+		mGeneration = 1;
+	}
+}
+
+GridAStar::GridAStar(unsigned int width, unsigned int height, const std::vector<bool>& passable,
+		bool diagonals)
+	: mWidth(width),
+	mHeight(height),
+	mStride(width + 2),
+	mDiagonals(diagonals),
+	mVersion(0)
+{
+	assert(passable.size() == width * height);
+	mPassable.assign(mStride * (height + 2), 0);
+	for(unsigned int y = 0; y < height; y++) {
+		for(unsigned int x = 0; x < width; x++) {
+			mPassable[cellIndex(x, y)] = passable[y * width + x];
+		}
+	}
+
+	for(int d = 0; d < 8; d++) {
+		mOffsets[d] = DY[d] * mStride + DX[d];
+	}
+}
+
+unsigned int GridAStar::getWidth() const
+{
+	return mWidth;
+}
+
+unsigned int GridAStar::getHeight() const
+{
+	return mHeight;
+}
+
+bool GridAStar::getDiagonals() const
+{
+	return mDiagonals;
+}
+
+bool GridAStar::isPassable(int x, int y) const
+{
+	if(x < 0 || y < 0 || x >= int(mWidth) || y >= int(mHeight))
+		return false;
+	return mPassable[cellIndex(x, y)];
+}
+
+void GridAStar::setPassable(int x, int y, bool passable)
+{
+	assert(x >= 0 && y >= 0 && x < int(mWidth) && y < int(mHeight));
+	mPassable[cellIndex(x, y)] = passable;
+	mJumpTable.clear();
+	mVersion++;
+}
+
+unsigned int GridAStar::getVersion() const
+{
+	return mVersion;
+}
+
+int GridAStar::moveCost(int d)
+{
+	return d < 4 ? ORTHOGONAL_COST : DIAGONAL_COST;
+}
+
+unsigned int GridAStar::getNumMoves() const
+{
+	return mDiagonals ? 8 : 4;
+}
+
+bool GridAStar::canMove(int x, int y, int d) const
+{
+	assert(d >= 0 && d < 8);
+	if(x < 0 || y < 0 || x >= int(mWidth) || y >= int(mHeight) || d >= int(getNumMoves()))
+		return false;
+	return canMoveFrom(cellIndex(x, y), d);
+}
+
+bool GridAStar::canMoveFrom(int cell, int d) const
+{
+	// the blocked border makes this the same as the generic canMove()
+	if(!mPassable[cell + mOffsets[d]])
+		return false;
+	return d < 4 || (mPassable[cell + DX[d]] && mPassable[cell + DY[d] * mStride]);
+}
+
+bool GridAStar::findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path)
+{
+	return findPath(start, goal, path, mScratch);
+}
+
+bool GridAStar::findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+		Scratch& scratch, unsigned int maxExpansions) const
+{
+	return search(start, goal, path, scratch, &GridAStar::neighbours, maxExpansions);
+}
+
+bool GridAStar::findPathJPS(const Point2& start, const Point2& goal, std::vector<Point2>& path)
+{
+	return findPathJPS(start, goal, path, mScratch);
+}
+
+bool GridAStar::findPathJPS(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+		Scratch& scratch) const
+{
+	assert(mDiagonals);
+	return search(start, goal, path, scratch, &GridAStar::jumpPoints);
+}
+
+void GridAStar::buildJumpTable()
+{
+	// For each cell and direction, the number of steps to the cell jump()
+	// would stop at, or if it would stop at none, minus the number of steps
+	// that can be taken before hitting a wall. Cells are filled in so that
+	// the next cell in the direction is always done first, straight
+	// directions before diagonal ones which depend on them.
+	mJumpTable.assign(mPassable.size() * 8, 0);
+	for(int diagonal = 0; diagonal < 2; diagonal++) {
+		for(int d = diagonal * 4; d < diagonal * 4 + 4; d++) {
+			int off = mOffsets[d];
+			for(unsigned int i = 0; i < mWidth * mHeight; i++) {
+				unsigned int j = off > 0 ? mWidth * mHeight - 1 - i : i;
+				int cell = cellIndex(j % mWidth, j / mWidth);
+				int next = cell + off;
+				int v;
+				if(!canMoveFrom(cell, d)) {
+					v = 0;
+				} else if(diagonal ? (mJumpTable[next * 8 + direction(DX[d], 0)] > 0 ||
+							mJumpTable[next * 8 + direction(0, DY[d])] > 0) :
+						forced(next, d)) {
+					v = 1;
+				} else {
+					int prev = mJumpTable[next * 8 + d];
+					v = prev > 0 ? prev + 1 : prev - 1;
+				}
+				mJumpTable[cell * 8 + d] = v;
+			}
+		}
+	}
+}
+
+bool GridAStar::hasJumpTable() const
+{
+	return !mJumpTable.empty();
+}
+
+unsigned int GridAStar::getExpansions() const
+{
+	return mScratch.getExpansions();
+}
+
+bool GridAStar::search(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+		Scratch& scratch, SuccessorFunc successors, unsigned int maxExpansions) const
+{
+	path.clear();
+	if(!isPassable(start.x, start.y) || !isPassable(goal.x, goal.y))
+		return false;
+
+	scratch.prepare(mPassable.size());
+	const unsigned int gen = scratch.mGeneration;
+	std::vector<Scratch::Cell>& cells = scratch.mCells;
+	std::vector<Scratch::OpenNode>& open = scratch.mOpen;
+
+	int startCell = cellIndex(start.x, start.y);
+	int goalCell = cellIndex(goal.x, goal.y);
+	cells[startCell].generation = gen;
+	cells[startCell].g = 0;
+	cells[startCell].parent = -1;
+	int h = heuristic(start, goal);
+	Scratch::OpenNode n = { h, h, startCell };
+	open.push_back(n);
+
+	Successor succ[8];
+	while(!open.empty()) {
+		std::pop_heap(open.begin(), open.end());
+		int current = open.back().cell;
+		open.pop_back();
+
+		// cells whose cost was lowered are left in the heap, so skip the
+		// stale entries
+		Scratch::Cell& c = cells[current];
+		if(c.closed == gen)
+			continue;
+		if(scratch.mExpansions == maxExpansions)
+			return false;
+		c.closed = gen;
+		scratch.mExpansions++;
+
+		if(current == goalCell) {
+			for(int i = current; i != -1; i = cells[i].parent) {
+				path.push_back(cellPoint(i));
+				int parent = cells[i].parent;
+				if(parent == -1)
+					break;
+
+				// fill in the cells jumped over
+				Point2 a = cellPoint(i);
+				Point2 b = cellPoint(parent);
+				int step = mOffsets[direction(signum(b.x - a.x), signum(b.y - a.y))];
+				for(int j = i + step; j != parent; j += step)
+					path.push_back(cellPoint(j));
+			}
+			std::reverse(path.begin(), path.end());
+			return true;
+		}
+
+		int num = (this->*successors)(current, c.parent, goalCell, succ);
+		for(int i = 0; i < num; i++) {
+			int next = succ[i].cell;
+			Scratch::Cell& nc = cells[next];
+			int g = c.g + succ[i].cost;
+			if(nc.generation == gen && (nc.closed == gen || nc.g <= g))
+				continue;
+
+			nc.generation = gen;
+			nc.g = g;
+			nc.parent = current;
+			h = heuristic(cellPoint(next), goal);
+			Scratch::OpenNode o = { g + h, h, next };
+			open.push_back(o);
+			std::push_heap(open.begin(), open.end());
+		}
+	}
+
+	return false;
+}
+
+int GridAStar::neighbours(int cell, int parent, int goal, Successor* out) const
+{
+	int num = 0;
+	int numDirs = getNumMoves();
+	for(int d = 0; d < numDirs; d++) {
+		if(!canMoveFrom(cell, d))
+			continue;
+
+		out[num].cell = cell + mOffsets[d];
+		out[num].cost = moveCost(d);
+		num++;
+	}
+	return num;
+}
+
+int GridAStar::jumpPoints(int cell, int parent, int goal, Successor* out) const
+{
+	// only the directions an optimal path could continue in from here
+	int dirs[8];
+	int numDirs = 0;
+	if(parent == -1) {
+		for(int d = 0; d < 8; d++)
+			dirs[numDirs++] = d;
+	} else {
+		Point2 p = cellPoint(parent);
+		Point2 c = cellPoint(cell);
+		int dx = signum(c.x - p.x);
+		int dy = signum(c.y - p.y);
+		if(dx && dy) {
+			dirs[numDirs++] = direction(dx, dy);
+			dirs[numDirs++] = direction(dx, 0);
+			dirs[numDirs++] = direction(0, dy);
+		} else if(dx) {
+			dirs[numDirs++] = direction(dx, 0);
+			dirs[numDirs++] = direction(dx, 1);
+			dirs[numDirs++] = direction(dx, -1);
+			dirs[numDirs++] = direction(0, 1);
+			dirs[numDirs++] = direction(0, -1);
+		} else {
+			dirs[numDirs++] = direction(0, dy);
+			dirs[numDirs++] = direction(1, dy);
+			dirs[numDirs++] = direction(-1, dy);
+			dirs[numDirs++] = direction(1, 0);
+			dirs[numDirs++] = direction(-1, 0);
+		}
+	}
+
+	int num = 0;
+	for(int i = 0; i < numDirs; i++) {
+		int next = jump(cell, dirs[i], goal);
+		if(next == -1)
+			continue;
+
+		out[num].cell = next;
+		out[num].cost = distance(cell, next);
+		num++;
+	}
+	return num;
+}
+
+int GridAStar::jump(int cell, int dir, int goal) const
+{
+	if(!mJumpTable.empty()) {
+		int v = mJumpTable[cell * 8 + dir];
+		Point2 c = cellPoint(cell);
+		Point2 g = cellPoint(goal);
+		int gx = g.x - c.x;
+		int gy = g.y - c.y;
+		if(dir < 4) {
+			// stop at the goal if it's on the way
+			bool onLine = DX[dir] ? gy == 0 && signum(gx) == DX[dir] : gx == 0 && signum(gy) == DY[dir];
+			if(onLine && abs(gx) + abs(gy) <= abs(v))
+				return goal;
+		} else if(signum(gx) == DX[dir] && signum(gy) == DY[dir]) {
+			// stop where the goal is straight ahead if that can be reached
+			int dist = std::min(abs(gx), abs(gy));
+			if(dist <= abs(v))
+				return cell + dist * mOffsets[dir];
+		}
+		return v > 0 ? cell + v * mOffsets[dir] : -1;
+	}
+
+	if(dir < 4)
+		return jumpStraight(cell, dir, goal);
+
+	int dirX = direction(DX[dir], 0);
+	int dirY = direction(0, DY[dir]);
+	while(1) {
+		if(!canMoveFrom(cell, dir))
+			return -1;
+		cell += mOffsets[dir];
+		if(cell == goal)
+			return cell;
+		if(jumpStraight(cell, dirX, goal) != -1 || jumpStraight(cell, dirY, goal) != -1)
+			return cell;
+	}
+}
+
+int GridAStar::jumpStraight(int cell, int dir, int goal) const
+{
+	while(1) {
+		cell += mOffsets[dir];
+		if(!mPassable[cell])
+			return -1;
+		if(cell == goal || forced(cell, dir))
+			return cell;
+	}
+}
+
+bool GridAStar::forced(int cell, int dir) const
+{
+	// a side cell that is open here but was blocked one step back can only be
+	// reached optimally through this cell
+	int side = DX[dir] ? mStride : 1;
+	int back = -mOffsets[dir];
+	return (mPassable[cell + side] && !mPassable[cell + side + back]) ||
+		(mPassable[cell - side] && !mPassable[cell - side + back]);
+}
+
+int GridAStar::distance(int a, int b) const
+{
+	Point2 pa = cellPoint(a);
+	Point2 pb = cellPoint(b);
+	return heuristic(pa, pb);
+}
+
+int GridAStar::cellIndex(int x, int y) const
+{
+	return (y + 1) * mStride + x + 1;
+}
+
+Point2 GridAStar::cellPoint(int cell) const
+{
+	return Point2(cell % mStride - 1, cell / mStride - 1);
+}
+
+int GridAStar::heuristic(const Point2& a, const Point2& b) const
+{
+	int dx = abs(a.x - b.x);
+	int dy = abs(a.y - b.y);
+	if(!mDiagonals)
+		return ORTHOGONAL_COST * (dx + dy);
+
+	// octile distance
+	return ORTHOGONAL_COST * (dx + dy) + (DIAGONAL_COST - 2 * ORTHOGONAL_COST) * std::min(dx, dy);
+}
+
+}
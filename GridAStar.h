@@ -0,0 +1,134 @@
+#ifndef COMMON_GRIDASTAR_H
+#define COMMON_GRIDASTAR_H
+
+#include <climits>
+#include <vector>
+
+#include "Line.h"
+
+namespace Common {
+
+// A* specialised for dense tile grids. Node state is kept in flat arrays
+// indexed by cell id and stamped with a search generation, so the arrays
+// are reused between searches without clearing them. Moves cost
+// ORTHOGONAL_COST or DIAGONAL_COST; diagonal moves may not cut corners.
+// On 8-connected grids Jump Point Search is available as well, which finds
+// paths of the same cost while only expanding the cells where the path may
+// turn, optionally with the jump distances precomputed (JPS+).
+class GridAStar {
+	public:
+		// Per search state. One is owned by the GridAStar itself; searching
+		// the same grid from several threads needs one per thread.
+		class Scratch {
+			public:
+				Scratch();
+				unsigned int getExpansions() const; // by the last search
+
+			private:
+				struct Cell {
+					unsigned int generation; // g and parent are valid if this is current
+					unsigned int closed; // expanded if this is current
+					int g;
+					int parent;
+				};
+				struct OpenNode {
+					int f;
+					int h;
+					int cell;
+					bool operator<(const OpenNode& rhs) const;
+				};
+				void prepare(unsigned int numCells);
+				std::vector<Cell> mCells;
+				std::vector<OpenNode> mOpen; // binary heap
+				unsigned int mGeneration;
+				unsigned int mExpansions;
+
+				friend class GridAStar;
+		};
+
+		// passable is row-major and width * height long
+		GridAStar(unsigned int width, unsigned int height, const std::vector<bool>& passable,
+				bool diagonals = true);
+		unsigned int getWidth() const;
+		unsigned int getHeight() const;
+		bool getDiagonals() const;
+		bool isPassable(int x, int y) const; // false outside the grid
+		void setPassable(int x, int y, bool passable);
+		// changed by setPassable(), for users caching results
+		unsigned int getVersion() const;
+		// shortest path from start to goal, both included, in path - false and
+		// an empty path if there is none, or if none was found within
+		// maxExpansions
+		bool findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path);
+		bool findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+				Scratch& scratch, unsigned int maxExpansions = UINT_MAX) const;
+		// the same using Jump Point Search, needs diagonal moves
+		bool findPathJPS(const Point2& start, const Point2& goal, std::vector<Point2>& path);
+		bool findPathJPS(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+				Scratch& scratch) const;
+		// precomputes the jump distances so that JPS needn't scan the grid,
+		// setPassable() discards them
+		void buildJumpTable();
+		bool hasJumpTable() const;
+		unsigned int getExpansions() const; // by the last search using the own scratch buffer
+		int heuristic(const Point2& a, const Point2& b) const;
+
+		static const int ORTHOGONAL_COST = 10;
+		static const int DIAGONAL_COST = 14;
+
+		// the moves, the first four orthogonal: move d goes from (x, y) to
+		// (x + MOVE_DX[d], y + MOVE_DY[d])
+		static const int MOVE_DX[8];
+		static const int MOVE_DY[8];
+		static int moveCost(int d);
+		unsigned int getNumMoves() const; // 8 with diagonals, otherwise 4
+		// whether move d may be taken from (x, y) on this grid
+		bool canMove(int x, int y, int d) const;
+		// the same rule for any grid where passable(x, y) tells the passable
+		// cells: into a passable cell, and diagonally only if both cells
+		// beside the corner are passable as well
+		template<typename F>
+		static bool canMove(const F& passable, int x, int y, int d);
+
+	private:
+		// cells are indexed in a grid padded with a blocked border so that
+		// neighbours never need bounds checks
+		int cellIndex(int x, int y) const;
+		bool canMoveFrom(int cell, int d) const; // canMove() on padded cell indices
+		Point2 cellPoint(int cell) const;
+		struct Successor {
+			int cell;
+			int cost;
+		};
+		typedef int (GridAStar::*SuccessorFunc)(int cell, int parent, int goal, Successor* out) const;
+		bool search(const Point2& start, const Point2& goal, std::vector<Point2>& path,
+				Scratch& scratch, SuccessorFunc successors,
+				unsigned int maxExpansions = UINT_MAX) const;
+		int neighbours(int cell, int parent, int goal, Successor* out) const;
+		int jumpPoints(int cell, int parent, int goal, Successor* out) const;
+		int jump(int cell, int dir, int goal) const;
+		int jumpStraight(int cell, int dir, int goal) const;
+		bool forced(int cell, int dir) const;
+		int distance(int a, int b) const;
+		unsigned int mWidth;
+		unsigned int mHeight;
+		unsigned int mStride;
+		bool mDiagonals;
+		unsigned int mVersion;
+		std::vector<unsigned char> mPassable;
+		int mOffsets[8];
+		std::vector<int> mJumpTable; // per cell and direction, see buildJumpTable()
+		Scratch mScratch;
+};
+
+template<typename F>
+bool GridAStar::canMove(const F& passable, int x, int y, int d)
+{
+	if(!passable(x + MOVE_DX[d], y + MOVE_DY[d]))
+		return false;
+	return d < 4 || (passable(x + MOVE_DX[d], y) && passable(x, y + MOVE_DY[d]));
+}
+
+}
+
+#endif
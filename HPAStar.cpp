@@ -0,0 +1,434 @@
+#include "HPAStar.h"
+
+#include <cassert>
+#include <climits>
+#include <cstdlib>
+
+#include <algorithm>
+#include <iostream>
+
+namespace Common {
+
+bool HPAStar::OpenNode::operator<(const OpenNode& rhs) const
+{
+	return f > rhs.f;
+}
+
+HPAStar::HPAStar(const GridAStar& grid, unsigned int clusterSize)
+	: mGrid(grid),
+	mClusterSize(clusterSize),
+	mDirty(true),
+	mCurrentGeneration(0),
+	mExpansions(0)
+{
+	assert(clusterSize > 0);
+	mClustersX = (grid.getWidth() + clusterSize - 1) / clusterSize;
+	mClustersY = (grid.getHeight() + clusterSize - 1) / clusterSize;
+	for(int j = 0; j < mClustersY; j++) {
+		for(int i = 0; i < mClustersX; i++) {
+			Cluster c;
+			c.x = i * mClusterSize;
+			c.y = j * mClusterSize;
+			c.w = std::min<int>(mClusterSize, grid.getWidth() - c.x);
+			c.h = std::min<int>(mClusterSize, grid.getHeight() - c.y);
+			c.dirty = true;
+			mClusters.push_back(c);
+		}
+	}
+
+	rebuild();
+}
+
+void HPAStar::tileChanged(int x, int y)
+{
+	assert(x >= 0 && y >= 0 && x < int(mGrid.getWidth()) && y < int(mGrid.getHeight()));
+	mClusters[clusterAt(Point2(x, y))].dirty = true;
+	mDirty = true;
+}
+
+void HPAStar::rebuild()
+{
+	if(!mDirty)
+		return;
+
+	// Entrances on the borders of the changed clusters. Borders between two
+	// changed clusters are done from the left or upper one only.
+	for(int j = 0; j < mClustersY; j++) {
+		for(int i = 0; i < mClustersX; i++) {
+			int c = j * mClustersX + i;
+			if(!mClusters[c].dirty)
+				continue;
+
+			if(i + 1 < mClustersX)
+				buildBorder(c, c + 1, true);
+			if(j + 1 < mClustersY)
+				buildBorder(c, c + mClustersX, false);
+			if(i > 0 && !mClusters[c - 1].dirty)
+				buildBorder(c - 1, c, true);
+			if(j > 0 && !mClusters[c - mClustersX].dirty)
+				buildBorder(c - mClustersX, c, false);
+		}
+	}
+
+	// the paths within all clusters whose entrances may have changed
+	for(int j = 0; j < mClustersY; j++) {
+		for(int i = 0; i < mClustersX; i++) {
+			int c = j * mClustersX + i;
+			bool affected = mClusters[c].dirty ||
+				(i > 0 && mClusters[c - 1].dirty) ||
+				(i + 1 < mClustersX && mClusters[c + 1].dirty) ||
+				(j > 0 && mClusters[c - mClustersX].dirty) ||
+				(j + 1 < mClustersY && mClusters[c + mClustersX].dirty);
+			if(!affected)
+				continue;
+
+			for(int n : mClusters[c].nodes)
+				mNodes[n].edges.clear();
+			for(int n : mClusters[c].nodes)
+				connect(n);
+		}
+	}
+
+	for(auto& c : mClusters)
+		c.dirty = false;
+	mDirty = false;
+}
+
+bool HPAStar::findAbstractPath(const Point2& start, const Point2& goal, std::vector<Point2>& waypoints)
+{
+	waypoints.clear();
+	mExpansions = 0;
+	rebuild();
+	if(!mGrid.isPassable(start.x, start.y) || !mGrid.isPassable(goal.x, goal.y))
+		return false;
+
+	if(start.x == goal.x && start.y == goal.y) {
+		waypoints.push_back(start);
+		return true;
+	}
+
+	// temporarily hook start and goal up to the entrances of their clusters
+	int startCluster = clusterAt(start);
+	int goalCluster = clusterAt(goal);
+	int s = addNode(start, startCluster);
+	int g = addNode(goal, goalCluster);
+
+	localSearch(startCluster, start, nullptr);
+	const Cluster& sc = mClusters[startCluster];
+	for(int n : sc.nodes) {
+		int cost = mLocalG[(mNodes[n].pos.x - sc.x) + (mNodes[n].pos.y - sc.y) * sc.w];
+		if(cost != INT_MAX) {
+			Edge e = { n, cost };
+			mNodes[s].edges.push_back(e);
+		}
+	}
+	if(startCluster == goalCluster) {
+		int cost = mLocalG[(goal.x - sc.x) + (goal.y - sc.y) * sc.w];
+		if(cost != INT_MAX) {
+			Edge e = { g, cost };
+			mNodes[s].edges.push_back(e);
+		}
+	}
+
+	localSearch(goalCluster, goal, nullptr);
+	const Cluster& gc = mClusters[goalCluster];
+	for(int n : gc.nodes) {
+		int cost = mLocalG[(mNodes[n].pos.x - gc.x) + (mNodes[n].pos.y - gc.y) * gc.w];
+		if(cost != INT_MAX) {
+			Edge e = { g, cost };
+			mNodes[n].edges.push_back(e);
+		}
+	}
+
+	bool found = abstractSearch(s, g, waypoints);
+
+	for(int n : gc.nodes) {
+		if(!mNodes[n].edges.empty() && mNodes[n].edges.back().node == g)
+			mNodes[n].edges.pop_back();
+	}
+	removeNode(s);
+	removeNode(g);
+	return found;
+}
+
+bool HPAStar::refine(const Point2& from, const Point2& to, std::vector<Point2>& path)
+{
+	path.clear();
+	int cluster = clusterAt(from);
+	if(cluster != clusterAt(to)) {
+		// a step across an entrance
+		if(abs(from.x - to.x) + abs(from.y - to.y) != 1)
+			return false;
+		path.push_back(from);
+		path.push_back(to);
+		return true;
+	}
+
+	if(!localSearch(cluster, from, &to))
+		return false;
+
+	const Cluster& c = mClusters[cluster];
+	for(int i = (to.x - c.x) + (to.y - c.y) * c.w; i != -1; i = mLocalParent[i]) {
+		path.push_back(Point2(c.x + i % c.w, c.y + i / c.w));
+	}
+	std::reverse(path.begin(), path.end());
+	return true;
+}
+
+bool HPAStar::findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path)
+{
+	path.clear();
+	std::vector<Point2> waypoints;
+	if(!findAbstractPath(start, goal, waypoints))
+		return false;
+
+	path.push_back(start);
+	std::vector<Point2> segment;
+	for(unsigned int i = 1; i < waypoints.size(); i++) {
+		if(!refine(waypoints[i - 1], waypoints[i], segment)) {
+			std::cout << "HPAStar: failed to refine path\n";
+			assert(0);
+			path.clear();
+			return false;
+		}
+		path.insert(path.end(), segment.begin() + 1, segment.end());
+	}
+	return true;
+}
+
+unsigned int HPAStar::getNumNodes() const
+{
+	return mNodes.size() - mFreeNodes.size();
+}
+
+unsigned int HPAStar::getExpansions() const
+{
+	return mExpansions;
+}
+
+int HPAStar::clusterAt(const Point2& p) const
+{
+	return (p.y / mClusterSize) * mClustersX + p.x / mClusterSize;
+}
+
+int HPAStar::addNode(const Point2& p, int cluster)
+{
+	int n;
+	if(!mFreeNodes.empty()) {
+		n = mFreeNodes.back();
+		mFreeNodes.pop_back();
+	} else {
+		n = mNodes.size();
+		mNodes.push_back(Node());
+	}
+
+	mNodes[n].pos = p;
+	mNodes[n].cluster = cluster;
+	mNodes[n].twin = -1;
+	mNodes[n].edges.clear();
+	return n;
+}
+
+void HPAStar::removeNode(int node)
+{
+	auto& nodes = mClusters[mNodes[node].cluster].nodes;
+	auto it = std::find(nodes.begin(), nodes.end(), node);
+	if(it != nodes.end()) {
+		*it = nodes.back();
+		nodes.pop_back();
+	}
+
+	mNodes[node].cluster = -1;
+	mNodes[node].twin = -1;
+	mNodes[node].edges.clear();
+	mFreeNodes.push_back(node);
+}
+
+void HPAStar::clearBorder(int a, int b)
+{
+	auto& nodes = mClusters[a].nodes;
+	for(unsigned int i = 0; i < nodes.size(); ) {
+		int n = nodes[i];
+		int twin = mNodes[n].twin;
+		if(twin != -1 && mNodes[twin].cluster == b) {
+			removeNode(twin);
+			removeNode(n); // moves the last node of a to i
+		} else {
+			i++;
+		}
+	}
+}
+
+void HPAStar::buildBorder(int a, int b, bool vertical)
+{
+	clearBorder(a, b);
+
+	// a is left of or above b; walk along the border looking for runs of
+	// cells that are open on both sides
+	const Cluster& ca = mClusters[a];
+	int length = vertical ? ca.h : ca.w;
+	int run = 0;
+	for(int i = 0; i <= length; i++) {
+		Point2 pa = vertical ? Point2(ca.x + ca.w - 1, ca.y + i) : Point2(ca.x + i, ca.y + ca.h - 1);
+		Point2 pb = vertical ? Point2(pa.x + 1, pa.y) : Point2(pa.x, pa.y + 1);
+		if(i < length && mGrid.isPassable(pa.x, pa.y) && mGrid.isPassable(pb.x, pb.y)) {
+			run++;
+			continue;
+		}
+
+		if(run == 0)
+			continue;
+
+		int first = i - run;
+		int last = i - 1;
+		int transitions[2] = { (first + last) / 2, -1 };
+		if(run >= MAX_ENTRANCE_WIDTH) {
+			transitions[0] = first;
+			transitions[1] = last;
+		}
+
+		for(int t : transitions) {
+			if(t == -1)
+				continue;
+			Point2 ta = vertical ? Point2(ca.x + ca.w - 1, ca.y + t) : Point2(ca.x + t, ca.y + ca.h - 1);
+			Point2 tb = vertical ? Point2(ta.x + 1, ta.y) : Point2(ta.x, ta.y + 1);
+			int na = addNode(ta, a);
+			int nb = addNode(tb, b);
+			mNodes[na].twin = nb;
+			mNodes[nb].twin = na;
+			mClusters[a].nodes.push_back(na);
+			mClusters[b].nodes.push_back(nb);
+		}
+		run = 0;
+	}
+}
+
+void HPAStar::connect(int node)
+{
+	int cluster = mNodes[node].cluster;
+	localSearch(cluster, mNodes[node].pos, nullptr);
+	const Cluster& c = mClusters[cluster];
+	for(int n : c.nodes) {
+		if(n == node)
+			continue;
+		int cost = mLocalG[(mNodes[n].pos.x - c.x) + (mNodes[n].pos.y - c.y) * c.w];
+		if(cost != INT_MAX) {
+			Edge e = { n, cost };
+			mNodes[node].edges.push_back(e);
+		}
+	}
+}
+
+bool HPAStar::localSearch(int cluster, const Point2& from, const Point2* to)
+{
+	// Dijkstra within the cluster, until to is reached if given
+	const Cluster& c = mClusters[cluster];
+	mLocalG.assign(c.w * c.h, INT_MAX);
+	mLocalParent.assign(c.w * c.h, -1);
+	mLocalOpen.clear();
+
+	int source = (from.x - c.x) + (from.y - c.y) * c.w;
+	int target = to ? (to->x - c.x) + (to->y - c.y) * c.w : -1;
+	mLocalG[source] = 0;
+	OpenNode o = { 0, source };
+	mLocalOpen.push_back(o);
+
+	int numDirs = mGrid.getNumMoves();
+	while(!mLocalOpen.empty()) {
+		std::pop_heap(mLocalOpen.begin(), mLocalOpen.end());
+		OpenNode current = mLocalOpen.back();
+		mLocalOpen.pop_back();
+		if(current.f > mLocalG[current.node])
+			continue;
+		if(current.node == target)
+			return true;
+
+		int x = c.x + current.node % c.w;
+		int y = c.y + current.node / c.w;
+		for(int d = 0; d < numDirs; d++) {
+			int nx = x + GridAStar::MOVE_DX[d];
+			int ny = y + GridAStar::MOVE_DY[d];
+			if(nx < c.x || ny < c.y || nx >= c.x + c.w || ny >= c.y + c.h)
+				continue;
+			if(!mGrid.canMove(x, y, d))
+				continue;
+
+			int next = (nx - c.x) + (ny - c.y) * c.w;
+			int g = current.f + GridAStar::moveCost(d);
+			if(g < mLocalG[next]) {
+				mLocalG[next] = g;
+				mLocalParent[next] = current.node;
+				OpenNode n = { g, next };
+				mLocalOpen.push_back(n);
+				std::push_heap(mLocalOpen.begin(), mLocalOpen.end());
+			}
+		}
+	}
+
+	return target == -1;
+}
+
+bool HPAStar::abstractSearch(int start, int goal, std::vector<Point2>& waypoints)
+{
+	if(mGeneration.size() != mNodes.size() || ++mCurrentGeneration == 0) {
+		mGeneration.assign(mNodes.size(), 0);
+		mClosed.assign(mNodes.size(), 0);
+		mG.resize(mNodes.size());
+		mParent.resize(mNodes.size());
+		mCurrentGeneration = 1;
+	}
+	const unsigned int gen = mCurrentGeneration;
+	const Point2& goalPos = mNodes[goal].pos;
+
+	mOpen.clear();
+	mGeneration[start] = gen;
+	mG[start] = 0;
+	mParent[start] = -1;
+	OpenNode o = { mGrid.heuristic(mNodes[start].pos, goalPos), start };
+	mOpen.push_back(o);
+
+	while(!mOpen.empty()) {
+		std::pop_heap(mOpen.begin(), mOpen.end());
+		int current = mOpen.back().node;
+		mOpen.pop_back();
+		if(mClosed[current] == gen)
+			continue;
+		mClosed[current] = gen;
+		mExpansions++;
+
+		if(current == goal) {
+			for(int i = current; i != -1; i = mParent[i])
+				waypoints.push_back(mNodes[i].pos);
+			std::reverse(waypoints.begin(), waypoints.end());
+			return true;
+		}
+
+		const Node& n = mNodes[current];
+		for(unsigned int i = 0; i <= n.edges.size(); i++) {
+			Edge e;
+			if(i < n.edges.size()) {
+				e = n.edges[i];
+			} else if(n.twin != -1) {
+				e.node = n.twin;
+				e.cost = GridAStar::ORTHOGONAL_COST;
+			} else {
+				break;
+			}
+
+			int g = mG[current] + e.cost;
+			if(mGeneration[e.node] == gen && (mClosed[e.node] == gen || mG[e.node] <= g))
+				continue;
+
+			mGeneration[e.node] = gen;
+			mG[e.node] = g;
+			mParent[e.node] = current;
+			OpenNode next = { g + mGrid.heuristic(mNodes[e.node].pos, goalPos), e.node };
+			mOpen.push_back(next);
+			std::push_heap(mOpen.begin(), mOpen.end());
+		}
+	}
+
+	return false;
+}
+
+}
@@ -0,0 +1,95 @@
+#ifndef COMMON_HPASTAR_H
+#define COMMON_HPASTAR_H
+
+#include <vector>
+
+#include "GridAStar.h"
+
+namespace Common {
+
+// Hierarchical pathfinding (HPA*) over the cells of a GridAStar. The map is
+// split into square clusters. Entrances are placed where neighbouring
+// clusters connect, and the path costs between the entrances of each
+// cluster are precomputed. A search then runs A* on this abstract graph
+// and only refines the steps of the result into cells, so that the cost
+// of long searches depends on the number of clusters crossed rather than
+// the number of cells. Paths are near optimal rather than optimal.
+// The grid is not owned; after changing it call tileChanged() so that the
+// affected clusters are rebuilt before the next search.
+class HPAStar {
+	public:
+		HPAStar(const GridAStar& grid, unsigned int clusterSize = 16);
+		void tileChanged(int x, int y);
+		// rebuilds the clusters marked by tileChanged(), done by the searches as well
+		void rebuild();
+		// start, the entrances passed through and goal - false and no
+		// waypoints if there is no path
+		bool findAbstractPath(const Point2& start, const Point2& goal, std::vector<Point2>& waypoints);
+		// cell path between two consecutive waypoints, both included
+		bool refine(const Point2& from, const Point2& to, std::vector<Point2>& path);
+		// findAbstractPath() refined into cells
+		bool findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path);
+		unsigned int getNumNodes() const;
+		unsigned int getExpansions() const; // abstract nodes expanded by the last search
+
+	private:
+		struct Edge {
+			int node;
+			int cost;
+		};
+		struct Node {
+			Point2 pos;
+			int cluster; // -1 if unused
+			int twin; // the node across the entrance, -1 for start and goal
+			std::vector<Edge> edges; // within the cluster
+		};
+		struct Cluster {
+			int x;
+			int y;
+			int w;
+			int h;
+			std::vector<int> nodes;
+			bool dirty;
+		};
+		struct OpenNode {
+			int f;
+			int node;
+			bool operator<(const OpenNode& rhs) const;
+		};
+		int clusterAt(const Point2& p) const;
+		int addNode(const Point2& p, int cluster);
+		void removeNode(int node);
+		void buildBorder(int a, int b, bool vertical);
+		void clearBorder(int a, int b);
+		void connect(int node);
+		bool localSearch(int cluster, const Point2& from, const Point2* to);
+		bool abstractSearch(int start, int goal, std::vector<Point2>& waypoints);
+		static const int MAX_ENTRANCE_WIDTH = 6; // longer entrances get a transition at both ends
+
+		const GridAStar& mGrid;
+		int mClusterSize;
+		int mClustersX;
+		int mClustersY;
+		std::vector<Cluster> mClusters;
+		std::vector<Node> mNodes;
+		std::vector<int> mFreeNodes;
+		bool mDirty;
+
+		// local search scratch, one cluster large
+		std::vector<int> mLocalG;
+		std::vector<int> mLocalParent;
+		std::vector<OpenNode> mLocalOpen;
+
+		// abstract search scratch, generation stamped as in GridAStar
+		std::vector<unsigned int> mGeneration;
+		std::vector<unsigned int> mClosed;
+		std::vector<int> mG;
+		std::vector<int> mParent;
+		std::vector<OpenNode> mOpen;
+		unsigned int mCurrentGeneration;
+		unsigned int mExpansions;
+};
+
+}
+
+#endif
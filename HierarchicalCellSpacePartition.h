@@ -0,0 +1,375 @@
+#ifndef COMMON_HIERARCHICALCELLSPACEPARTITION_H
+#define COMMON_HIERARCHICALCELLSPACEPARTITION_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include "Math.h"
+#include "Vector2.h"
+#include "Partition.h"
+
+namespace Common {
+
+// Cell space partition with several grid resolutions for mixed query
+// radii. Members are stored in the finest level. Each coarser level groups
+// factor * factor cells of the level below and only keeps a count of the
+// members within each cell. Queries start from the level whose cell size
+// matches the query and descend from there, skipping empty cells.
+template<class T>
+class HierarchicalCellSpacePartition {
+	public:
+		inline HierarchicalCellSpacePartition(float w, float h,
+				unsigned int cellsx, unsigned int cellsy,
+				unsigned int levels = 3, unsigned int factor = 4);
+		inline void add(T& t, const Vector2& p);
+		inline void remove(T& t, const Vector2& p);
+		inline void update(T& t, const Vector2& oldpos, const Vector2& newpos);
+		inline unsigned int size() const;
+		// the queries keep no state and may run concurrently
+		inline void query(const AABB& area, std::vector<T>& out) const; // appends to out
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const; // calls visitor(const T&, const Vector2&)
+		// k nearest members to p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		// members within radius of p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const;
+
+	private:
+		struct Level {
+			unsigned int cellsx;
+			unsigned int cellsy;
+			unsigned int scale; // width of a cell in finest level cells
+			std::vector<unsigned int> counts; // unused for the finest level
+		};
+
+		typedef std::vector<std::pair<T, Vector2>> Members;
+
+		inline void positionToCell(const Vector2& p, int& i, int& j) const;
+		inline void addCount(int i, int j, int diff);
+		inline unsigned int count(unsigned int level, int i, int j) const;
+		inline AABB cellBox(unsigned int level, int i, int j) const;
+		inline unsigned int pickLevel(const AABB& area) const;
+		template<typename F>
+		inline void forEachCell(const AABB& area, F&& f) const;
+		template<typename F>
+		inline void visitCell(unsigned int level, int i, int j,
+				int minx, int miny, int maxx, int maxy, F& f) const;
+		inline void nearestCell(unsigned int level, int i, int j,
+				const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		static const unsigned int MAX_FACTOR = 8;
+		float mWidth;
+		float mHeight;
+
+		float mCellWidth;
+		float mCellHeight;
+
+		unsigned int mFactor;
+		unsigned int mSize;
+
+		std::vector<Members> mCells;
+		std::vector<Level> mLevels;
+};
+
+template<class T>
+HierarchicalCellSpacePartition<T>::HierarchicalCellSpacePartition(float w, float h,
+		unsigned int cellsx, unsigned int cellsy, unsigned int levels, unsigned int factor)
+	: mWidth(w),
+	mHeight(h),
+	mFactor(factor),
+	mSize(0)
+{
+	assert(levels >= 1);
+	assert(factor >= 2 && factor <= MAX_FACTOR);
+	mCellWidth  = ceil(mWidth  / (float)cellsx);
+	mCellHeight = ceil(mHeight / (float)cellsy);
+	mCells.resize(cellsx * cellsy);
+
+	unsigned int scale = 1;
+	for(unsigned int l = 0; l < levels; l++) {
+		Level lev;
+		lev.scale = scale;
+		lev.cellsx = (cellsx + scale - 1) / scale;
+		lev.cellsy = (cellsy + scale - 1) / scale;
+		if(l > 0)
+			lev.counts.resize(lev.cellsx * lev.cellsy);
+		mLevels.push_back(lev);
+		scale *= factor;
+	}
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::add(T& t, const Vector2& p)
+{
+	int i, j;
+	positionToCell(p, i, j);
+	mCells[j * mLevels[0].cellsx + i].push_back(std::make_pair(t, p));
+	addCount(i, j, 1);
+	mSize++;
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::remove(T& t, const Vector2& p)
+{
+	int i, j;
+	positionToCell(p, i, j);
+	auto& c = mCells[j * mLevels[0].cellsx + i];
+	for(unsigned int m = 0; m < c.size(); m++) {
+		if(c[m].first == t) {
+			c[m] = c.back();
+			c.pop_back();
+			addCount(i, j, -1);
+			mSize--;
+			return;
+		}
+	}
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::update(T& t, const Vector2& oldpos, const Vector2& newpos)
+{
+	int i1, j1, i2, j2;
+	positionToCell(oldpos, i1, j1);
+	positionToCell(newpos, i2, j2);
+	if(i1 == i2 && j1 == j2) {
+		for(auto& m : mCells[j1 * mLevels[0].cellsx + i1]) {
+			if(m.first == t) {
+				m.second = newpos;
+				break;
+			}
+		}
+		return;
+	}
+
+	remove(t, oldpos);
+	add(t, newpos);
+}
+
+template<class T>
+unsigned int HierarchicalCellSpacePartition<T>::size() const
+{
+	return mSize;
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::query(const AABB& area, std::vector<T>& out) const
+{
+	query(area, [&out] (const T& t, const Vector2&) { out.push_back(t); });
+}
+
+template<class T>
+template<typename F>
+void HierarchicalCellSpacePartition<T>::query(const AABB& area, F&& visitor) const
+{
+	forEachCell(area, [&] (const Members& c, int, int) {
+			for(auto& m : c) {
+				if(area.contains(m.second))
+					visitor(m.first, m.second);
+			}
+			});
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	if(k == 0)
+		return;
+
+	// rings of cells on the coarsest level, best first descent below that
+	unsigned int top = mLevels.size() - 1;
+	const Level& lev = mLevels[top];
+	int ci, cj;
+	positionToCell(p, ci, cj);
+	ci /= lev.scale;
+	cj /= lev.scale;
+
+	float cellSize = std::min(mCellWidth, mCellHeight) * lev.scale;
+	int maxRing = std::max(lev.cellsx, lev.cellsy);
+	for(int r = 0; r <= maxRing; r++) {
+		float ringDist = (r - 1) * cellSize;
+		if(r > 1 && ringDist * ringDist > nearestBound(out, k))
+			break;
+
+		for(int j = cj - r; j <= cj + r; j++) {
+			if(j < 0 || j >= int(lev.cellsy))
+				continue;
+
+			bool edgeRow = j == cj - r || j == cj + r;
+			int step = edgeRow || r == 0 ? 1 : 2 * r;
+			for(int i = ci - r; i <= ci + r; i += step) {
+				if(i < 0 || i >= int(lev.cellsx))
+					continue;
+
+				if(count(top, i, j) == 0 || cellBox(top, i, j).distance2(p) > nearestBound(out, k))
+					continue;
+
+				nearestCell(top, i, j, p, k, out);
+			}
+		}
+	}
+
+	std::sort_heap(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::nearestCell(unsigned int level, int i, int j,
+		const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	if(level == 0) {
+		for(auto& m : mCells[j * mLevels[0].cellsx + i]) {
+			pushNearest(out, k, p.distance2(m.second), m.first);
+		}
+		return;
+	}
+
+	// descend into the nearest non-empty children first
+	const Level& child = mLevels[level - 1];
+	int ci[MAX_FACTOR * MAX_FACTOR];
+	int cj[MAX_FACTOR * MAX_FACTOR];
+	float dists[MAX_FACTOR * MAX_FACTOR];
+	int order[MAX_FACTOR * MAX_FACTOR];
+	int num = 0;
+	int maxi = std::min<int>((i + 1) * mFactor, child.cellsx);
+	int maxj = std::min<int>((j + 1) * mFactor, child.cellsy);
+	for(int y = j * mFactor; y < maxj; y++) {
+		for(int x = i * mFactor; x < maxi; x++) {
+			if(count(level - 1, x, y) == 0)
+				continue;
+			ci[num] = x;
+			cj[num] = y;
+			dists[num] = cellBox(level - 1, x, y).distance2(p);
+			order[num] = num;
+			num++;
+		}
+	}
+	std::sort(order, order + num, [&dists] (int a, int b) { return dists[a] < dists[b]; });
+
+	for(int n = 0; n < num; n++) {
+		if(dists[order[n]] > nearestBound(out, k))
+			break;
+		nearestCell(level - 1, ci[order[n]], cj[order[n]], p, k, out);
+	}
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+
+	float radius2 = radius * radius;
+	forEachCell(AABB(p, Vector2(radius, radius)), [&] (const Members& c, int i, int j) {
+			if(cellBox(0, i, j).distance2(p) > radius2)
+				return;
+
+			for(auto& m : c) {
+				float d2 = p.distance2(m.second);
+				if(d2 <= radius2) {
+					out.push_back(std::make_pair(d2, m.first));
+				}
+			}
+			});
+
+	std::sort(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::positionToCell(const Vector2& p, int& i, int& j) const
+{
+	// finest level, clamped to the grid
+	i = clamp<int>(0, floor((p.x + mWidth * 0.5f) / mCellWidth), mLevels[0].cellsx - 1);
+	j = clamp<int>(0, floor((p.y + mHeight * 0.5f) / mCellHeight), mLevels[0].cellsy - 1);
+}
+
+template<class T>
+void HierarchicalCellSpacePartition<T>::addCount(int i, int j, int diff)
+{
+	for(unsigned int l = 1; l < mLevels.size(); l++) {
+		Level& lev = mLevels[l];
+		lev.counts[(j / lev.scale) * lev.cellsx + i / lev.scale] += diff;
+	}
+}
+
+template<class T>
+unsigned int HierarchicalCellSpacePartition<T>::count(unsigned int level, int i, int j) const
+{
+	const Level& lev = mLevels[level];
+	if(level == 0)
+		return mCells[j * lev.cellsx + i].size();
+	else
+		return lev.counts[j * lev.cellsx + i];
+}
+
+template<class T>
+AABB HierarchicalCellSpacePartition<T>::cellBox(unsigned int level, int i, int j) const
+{
+	float cw = mCellWidth * mLevels[level].scale;
+	float ch = mCellHeight * mLevels[level].scale;
+	return AABB(Vector2((i + 0.5f) * cw - mWidth * 0.5f,
+				(j + 0.5f) * ch - mHeight * 0.5f),
+			Vector2(cw * 0.5f, ch * 0.5f));
+}
+
+template<class T>
+unsigned int HierarchicalCellSpacePartition<T>::pickLevel(const AABB& area) const
+{
+	// the coarsest level whose cells are no larger than the query
+	float extent = 2.0f * std::max(area.halfDimension.x, area.halfDimension.y);
+	unsigned int level = 0;
+	while(level + 1 < mLevels.size() &&
+			std::min(mCellWidth, mCellHeight) * mLevels[level + 1].scale <= extent)
+		level++;
+	return level;
+}
+
+template<class T>
+template<typename F>
+void HierarchicalCellSpacePartition<T>::forEachCell(const AABB& area, F&& f) const
+{
+	// range of finest level cells covered by the area
+	int minx, miny, maxx, maxy;
+	positionToCell(area.center - area.halfDimension, minx, miny);
+	positionToCell(area.center + area.halfDimension, maxx, maxy);
+
+	unsigned int level = pickLevel(area);
+	unsigned int scale = mLevels[level].scale;
+	for(int j = miny / scale; j <= maxy / int(scale); j++) {
+		for(int i = minx / scale; i <= maxx / int(scale); i++) {
+			visitCell(level, i, j, minx, miny, maxx, maxy, f);
+		}
+	}
+}
+
+template<class T>
+template<typename F>
+void HierarchicalCellSpacePartition<T>::visitCell(unsigned int level, int i, int j,
+		int minx, int miny, int maxx, int maxy, F& f) const
+{
+	if(count(level, i, j) == 0)
+		return;
+
+	if(level == 0) {
+		f(mCells[j * mLevels[0].cellsx + i], i, j);
+		return;
+	}
+
+	// children of this cell that are within the range
+	int scale = mLevels[level - 1].scale;
+	int x0 = std::max<int>(i * mFactor, minx / scale);
+	int x1 = std::min<int>((i + 1) * mFactor - 1, maxx / scale);
+	int y0 = std::max<int>(j * mFactor, miny / scale);
+	int y1 = std::min<int>((j + 1) * mFactor - 1, maxy / scale);
+	for(int y = y0; y <= y1; y++) {
+		for(int x = x0; x <= x1; x++) {
+			visitCell(level - 1, x, y, minx, miny, maxx, maxy, f);
+		}
+	}
+}
+
+}
+
+#endif
@@ -4,9 +4,12 @@
 #include <cassert>
 #include <cmath>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <queue>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "Partition.h"
@@ -35,23 +38,41 @@ class LQTIterator {
 template<class T>
 class LineQuadTree {
 	public:
-		inline LineQuadTree(const AABB& boundary);
+		// With looseness > 1 the tree is a loose quadtree: the bounds of each
+		// node are enlarged by that factor and a line is pushed down into the
+		// child its center is in for as long as it fits the child's loose bounds.
+		// The depth of a line then only depends on its size, so long lines no
+		// longer pile up near the root. 2 is a typical value.
+		inline LineQuadTree(const AABB& boundary, float looseness = 1.0f);
+		// bulk load - lines outside the boundary are ignored
+		inline LineQuadTree(const AABB& boundary, const std::vector<std::pair<T, AABB>>& lines,
+				unsigned int threads = 1, float looseness = 1.0f);
 		inline ~LineQuadTree();
 		inline bool insert(T& t, const AABB& p); // invalidates all iterators
 		inline bool deleteT(T& t, const AABB& p); // invalidates all iterators
 		inline bool update(T& t, const AABB& oldpos, const AABB& newpos); // invalidates all iterators - slow
 		inline void clear();
 		inline std::vector<T> query(const AABB& area) const;
+		inline void query(const AABB& area, std::vector<T>& out) const; // appends to out
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const; // calls visitor(const T&), no allocations
 		inline unsigned int size() const;
 		inline LQTIterator<T> begin();
 		inline LQTIterator<T> end();
 
 	private:
+		typedef typename std::vector<std::pair<T, AABB>>::iterator BuildIterator;
+		inline void build(BuildIterator begin, BuildIterator end, unsigned int threads);
 		inline void subdivide();
+		inline LineQuadTree* child(const Vector2& p) const;
+		inline AABB looseChildBoundary(const Vector2& p) const;
 		inline bool updateClean(T& t, const AABB& oldpos, const AABB& newpos);
 		inline LineQuadTree<T>* find(T& t, const AABB& pos);
+		static const unsigned int PARALLEL_BUILD_MIN = 4096;
 		constexpr static const float MIN_DIMENSION = 8.0f;
 		AABB mBoundary;
+		AABB mLooseBoundary;
+		float mLooseness;
 		std::map<T, AABB> mLines;
 		LineQuadTree* mNW;
 		LineQuadTree* mNE;
@@ -62,8 +83,10 @@ class LineQuadTree {
 };
 
 template<class T>
-LineQuadTree<T>::LineQuadTree(const AABB& boundary)
+LineQuadTree<T>::LineQuadTree(const AABB& boundary, float looseness)
 	: mBoundary(boundary),
+	mLooseBoundary(boundary.center, boundary.halfDimension * looseness),
+	mLooseness(looseness),
 	mNW(nullptr),
 	mNE(nullptr),
 	mSW(nullptr),
@@ -71,6 +94,21 @@ LineQuadTree<T>::LineQuadTree(const AABB& boundary)
 {
 }
 
+template<class T>
+LineQuadTree<T>::LineQuadTree(const AABB& boundary, const std::vector<std::pair<T, AABB>>& lines,
+		unsigned int threads, float looseness)
+	: LineQuadTree(boundary, looseness)
+{
+	std::vector<std::pair<T, AABB>> items;
+	items.reserve(lines.size());
+	for(auto& l : lines) {
+		if(mLooseBoundary.contains(l.second))
+			items.push_back(l);
+	}
+
+	build(items.begin(), items.end(), threads);
+}
+
 template<class T>
 LineQuadTree<T>::~LineQuadTree()
 {
@@ -85,7 +123,7 @@ LineQuadTree<T>::~LineQuadTree()
 template<class T>
 bool LineQuadTree<T>::insert(T& t, const AABB& p)
 {
-	if(!mBoundary.contains(p)) {
+	if(!mLooseBoundary.contains(p)) {
 		return false;
 	}
 
@@ -95,6 +133,23 @@ bool LineQuadTree<T>::insert(T& t, const AABB& p)
 		return true;
 	}
 
+	if(mLooseness > 1.0f) {
+		// only subdivide once something fits in a child
+		if(mNW == nullptr && !looseChildBoundary(p.center).contains(p)) {
+			mLines.insert({t, p});
+			return true;
+		}
+
+		if(mNW == nullptr) {
+			subdivide();
+		}
+
+		if(!child(p.center)->insert(t, p)) {
+			mLines.insert({t, p});
+		}
+		return true;
+	}
+
 	if(mNW == nullptr) {
 		subdivide();
 	}
@@ -111,7 +166,7 @@ bool LineQuadTree<T>::insert(T& t, const AABB& p)
 template<class T>
 bool LineQuadTree<T>::deleteT(T& t, const AABB& p)
 {
-	if(!mBoundary.contains(p)) {
+	if(!mLooseBoundary.contains(p)) {
 		return false;
 	}
 
@@ -125,6 +180,10 @@ bool LineQuadTree<T>::deleteT(T& t, const AABB& p)
 		return false;
 	}
 
+	if(mLooseness > 1.0f) {
+		return child(p.center)->deleteT(t, p);
+	}
+
 	if(mNW->deleteT(t, p)) return true;
 	if(mNE->deleteT(t, p)) return true;
 	if(mSW->deleteT(t, p)) return true;
@@ -157,41 +216,37 @@ template<class T>
 std::vector<T> LineQuadTree<T>::query(const AABB& area) const
 {
 	std::vector<T> retvalues;
+	query(area, retvalues);
+	return retvalues;
+}
 
-	if(!mBoundary.intersects(area))
-		return retvalues;
+template<class T>
+void LineQuadTree<T>::query(const AABB& area, std::vector<T>& out) const
+{
+	query(area, [&out] (const T& t) { out.push_back(t); });
+}
+
+template<class T>
+template<typename F>
+void LineQuadTree<T>::query(const AABB& area, F&& visitor) const
+{
+	if(!mLooseBoundary.intersects(area))
+		return;
 
 	for(auto& p : mLines) {
 		if(area.intersects(p.second)) {
-			retvalues.push_back(p.first);
+			visitor(p.first);
 		}
 	}
 
 	if(mNW == nullptr) {
-		return retvalues;
-	}
-
-	{
-		std::vector<T> moreretvalues = mNW->query(area);
-		retvalues.insert(retvalues.end(), moreretvalues.begin(), moreretvalues.end());
+		return;
 	}
 
-	{
-		std::vector<T> moreretvalues = mNE->query(area);
-		retvalues.insert(retvalues.end(), moreretvalues.begin(), moreretvalues.end());
-	}
-
-	{
-		std::vector<T> moreretvalues = mSW->query(area);
-		retvalues.insert(retvalues.end(), moreretvalues.begin(), moreretvalues.end());
-	}
-
-	{
-		std::vector<T> moreretvalues = mSE->query(area);
-		retvalues.insert(retvalues.end(), moreretvalues.begin(), moreretvalues.end());
-	}
-
-	return retvalues;
+	mNW->query(area, visitor);
+	mNE->query(area, visitor);
+	mSW->query(area, visitor);
+	mSE->query(area, visitor);
 }
 
 template<class T>
@@ -209,6 +264,64 @@ unsigned int LineQuadTree<T>::size() const
 	return v;
 }
 
+template<class T>
+void LineQuadTree<T>::build(BuildIterator begin, BuildIterator end, unsigned int threads)
+{
+	if(begin == end)
+		return;
+
+	if(mBoundary.halfDimension.x * 2.0f <= MIN_DIMENSION ||
+			mBoundary.halfDimension.y * 2.0f <= MIN_DIMENSION) {
+		mLines.insert(begin, end);
+		return;
+	}
+
+	BuildIterator bounds[5];
+	bounds[0] = begin;
+
+	if(mLooseness > 1.0f) {
+		BuildIterator down = std::partition(begin, end,
+				[this] (const std::pair<T, AABB>& l) {
+				return looseChildBoundary(l.second.center).contains(l.second); });
+		mLines.insert(down, end);
+		if(down == begin)
+			return;
+
+		subdivide();
+
+		// group by the child the center is in
+		const Vector2 c = mBoundary.center;
+		bounds[4] = down;
+		bounds[2] = std::partition(begin, down, [&c] (const std::pair<T, AABB>& l) { return l.second.center.y <= c.y; });
+		bounds[1] = std::partition(begin, bounds[2], [&c] (const std::pair<T, AABB>& l) { return l.second.center.x <= c.x; });
+		bounds[3] = std::partition(bounds[2], down, [&c] (const std::pair<T, AABB>& l) { return l.second.center.x <= c.x; });
+	} else {
+		subdivide();
+
+		// same child preference as insert(), lines that fit no child stay here
+		for(int i = 0; i < 4; i++) {
+			const AABB& b = (i == 0 ? mNW : i == 1 ? mNE : i == 2 ? mSW : mSE)->mBoundary;
+			bounds[i + 1] = std::partition(bounds[i], end,
+					[&b] (const std::pair<T, AABB>& l) { return b.contains(l.second); });
+		}
+		mLines.insert(bounds[4], end);
+	}
+
+	LineQuadTree* children[] = { mNW, mNE, mSW, mSE };
+
+	if(threads > 1 && (unsigned int)(end - begin) >= PARALLEL_BUILD_MIN) {
+		std::thread workers[4];
+		for(int i = 0; i < 4; i++)
+			workers[i] = std::thread(&LineQuadTree<T>::build, children[i],
+					bounds[i], bounds[i + 1], (threads + 3) / 4);
+		for(auto& w : workers)
+			w.join();
+	} else {
+		for(int i = 0; i < 4; i++)
+			children[i]->build(bounds[i], bounds[i + 1], 1);
+	}
+}
+
 template<class T>
 void LineQuadTree<T>::subdivide()
 {
@@ -220,16 +333,36 @@ void LineQuadTree<T>::subdivide()
 	float my = mBoundary.halfDimension.y * 0.5f;
 	mNW = new LineQuadTree(AABB(Vector2(mBoundary.center.x - mx,
 					mBoundary.center.y - my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), mLooseness);
 	mNE = new LineQuadTree(AABB(Vector2(mBoundary.center.x + mx,
 					mBoundary.center.y - my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), mLooseness);
 	mSW = new LineQuadTree(AABB(Vector2(mBoundary.center.x - mx,
 					mBoundary.center.y + my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), mLooseness);
 	mSE = new LineQuadTree(AABB(Vector2(mBoundary.center.x + mx,
 					mBoundary.center.y + my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), mLooseness);
+}
+
+template<class T>
+LineQuadTree<T>* LineQuadTree<T>::child(const Vector2& p) const
+{
+	if(p.x > mBoundary.center.x)
+		return p.y > mBoundary.center.y ? mSE : mNE;
+	else
+		return p.y > mBoundary.center.y ? mSW : mNW;
+}
+
+template<class T>
+AABB LineQuadTree<T>::looseChildBoundary(const Vector2& p) const
+{
+	// loose bounds of the child p is in, whether or not it exists yet
+	float mx = mBoundary.halfDimension.x * 0.5f;
+	float my = mBoundary.halfDimension.y * 0.5f;
+	return AABB(Vector2(p.x > mBoundary.center.x ? mBoundary.center.x + mx : mBoundary.center.x - mx,
+				p.y > mBoundary.center.y ? mBoundary.center.y + my : mBoundary.center.y - my),
+			Vector2(mx, my) * mLooseness);
 }
 
 template<class T>
@@ -253,7 +386,7 @@ bool LineQuadTree<T>::updateClean(T& t, const AABB& oldpos, const AABB& newpos)
 template<class T>
 LineQuadTree<T>* LineQuadTree<T>::find(T& t, const AABB& pos)
 {
-	if(!mBoundary.contains(pos)) {
+	if(!mLooseBoundary.contains(pos)) {
 		return nullptr;
 	}
 
@@ -265,6 +398,10 @@ LineQuadTree<T>* LineQuadTree<T>::find(T& t, const AABB& pos)
 		return nullptr;
 	}
 
+	if(mLooseness > 1.0f) {
+		return child(pos.center)->find(t, pos);
+	}
+
 	LineQuadTree* ret;
 	ret = mNW->find(t, pos); if(ret) return ret;
 	ret = mNE->find(t, pos); if(ret) return ret;
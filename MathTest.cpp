@@ -2,8 +2,10 @@
 
 #include <iostream>
 #include <cstdlib>
+#include <vector>
 
 #include "Math.h"
+#include "VectorMath.h"
 
 using namespace Common;
 
@@ -71,3 +73,126 @@ int math_quaternion(int argc, char** argv)
 	return 0;
 }
 
+
+template<typename T>
+static T randomVector();
+
+template<>
+Vector2 randomVector<Vector2>()
+{
+	// some zero vectors
+	if(rand() % 10 == 0)
+		return Vector2();
+	return Vector2(rand() % 2000 / 7.0f - 140, rand() % 2000 / 7.0f - 140);
+}
+
+template<>
+Vector3 randomVector<Vector3>()
+{
+	if(rand() % 10 == 0)
+		return Vector3();
+	return Vector3(rand() % 2000 / 7.0f - 140, rand() % 2000 / 7.0f - 140, rand() % 2000 / 7.0f - 140);
+}
+
+static bool same(const Vector2& a, const Vector2& b)
+{
+	return a.x == b.x && a.y == b.y;
+}
+
+static bool same(const Vector3& a, const Vector3& b)
+{
+	return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// the array functions must give exactly what the scalar ones give
+template<typename T>
+static bool test_vectormath(unsigned int n)
+{
+	std::vector<T> a, b;
+	for(unsigned int i = 0; i < n; i++) {
+		a.push_back(randomVector<T>());
+		b.push_back(randomVector<T>());
+	}
+	float s = rand() % 100 / 10.0f - 5.0f;
+	float len = rand() % 100;
+	float angle = rand() % 100 / 10.0f - 5.0f;
+
+	std::vector<T> v(n);
+	std::vector<float> f(n);
+	const char* failed = nullptr;
+
+	VectorMath::add(a.data(), b.data(), v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(!same(v[i], a[i] + b[i]))
+			failed = "add";
+	VectorMath::addScaled(a.data(), b.data(), s, v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(!same(v[i], a[i] + b[i] * s))
+			failed = "addScaled";
+	VectorMath::scale(a.data(), s, v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(!same(v[i], a[i] * s))
+			failed = "scale";
+	VectorMath::dot(a.data(), b.data(), f.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(f[i] != float(a[i].dot(b[i])))
+			failed = "dot";
+	VectorMath::length(a.data(), f.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(f[i] != a[i].length())
+			failed = "length";
+	VectorMath::distance2(a.data(), b.data(), f.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(f[i] != a[i].distance2(b[i]))
+			failed = "distance2";
+	VectorMath::rotate2D(a.data(), angle, v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(!same(v[i], Math::rotate2D(a[i], angle)))
+			failed = "rotate2D";
+
+	// in place
+	v = a;
+	VectorMath::normalize(v.data(), v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++)
+		if(!same(v[i], a[i].normalized()))
+			failed = "normalize";
+	v = a;
+	VectorMath::truncate(v.data(), len, v.data(), n);
+	for(unsigned int i = 0; i < n && !failed; i++) {
+		T t(a[i]);
+		t.truncate(len);
+		if(!same(v[i], t))
+			failed = "truncate";
+	}
+
+	if(failed) {
+		std::cout << "VectorMath " << VectorMath::getISAName(VectorMath::getISA()) << ": " << failed
+			<< " of " << n << " vectors differs\n";
+		return false;
+	}
+	return true;
+}
+
+int math_vectormath(int argc, char** argv)
+{
+	VectorMath::ISA best = VectorMath::getISA();
+	VectorMath::ISA isas[] = { VectorMath::ISA::Scalar, VectorMath::ISA::SSE, VectorMath::ISA::AVX };
+	int tests = 0;
+	for(auto isa : isas) {
+		if(!VectorMath::setISA(isa))
+			continue;
+		for(int i = 0; i < 20; i++) {
+			// the tails of every length
+			unsigned int n = i < 17 ? i : rand() % 1000;
+			if(!test_vectormath<Vector2>(n) || !test_vectormath<Vector3>(n)) {
+				VectorMath::setISA(best);
+				return 1;
+			}
+			tests++;
+		}
+	}
+	VectorMath::setISA(best);
+
+	std::cout << "Successfully passed " << tests << " tests.\n";
+	return 0;
+}
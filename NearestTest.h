@@ -0,0 +1,60 @@
+#ifndef COMMON_NEARESTTEST_H
+#define COMMON_NEARESTTEST_H
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+// Checks nearest() and withinRadius() of a spatial partition holding
+// element j at positions[j], unless removed[j] is set, against a brute
+// force search. Prints what was wrong and returns false on a mismatch.
+template<typename Partition, typename Vec>
+bool checkNearest(const char* name, const Partition& partition, const std::vector<Vec>& positions,
+		const Vec& p, unsigned int num, float radius,
+		const std::vector<bool>& removed = std::vector<bool>())
+{
+	std::vector<float> dists;
+	std::vector<int> inRadius;
+	for(unsigned int j = 0; j < positions.size(); j++) {
+		if(!removed.empty() && removed[j])
+			continue;
+		float d2 = p.distance2(positions[j]);
+		dists.push_back(d2);
+		if(d2 <= radius * radius)
+			inRadius.push_back(j);
+	}
+	std::sort(dists.begin(), dists.end());
+	dists.resize(std::min<unsigned int>(num, dists.size()));
+
+	std::vector<std::pair<float, int>> res;
+	partition.nearest(p, num, res);
+	bool ok = res.size() == dists.size();
+	for(unsigned int j = 0; ok && j < dists.size(); j++) {
+		ok = res[j].first == dists[j];
+	}
+	if(!ok) {
+		printf("%s: nearest returned wrong neighbours\n", name);
+		return false;
+	}
+
+	partition.withinRadius(p, radius, res);
+	std::vector<int> ids;
+	for(unsigned int j = 0; j < res.size(); j++) {
+		ids.push_back(res[j].second);
+		if(j > 0 && res[j].first < res[j - 1].first) {
+			printf("%s: withinRadius results not sorted\n", name);
+			return false;
+		}
+	}
+	std::sort(ids.begin(), ids.end());
+	if(ids != inRadius) {
+		printf("%s: withinRadius returned %zu points, expected %zu\n",
+				name, ids.size(), inRadius.size());
+		return false;
+	}
+	return true;
+}
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef COMMON_OCTREE_H
+#define COMMON_OCTREE_H
+
+#include "PointTree.h"
+
+namespace Common {
+
+// Point octree for 3D positions, laid out like FlatQuadTree with eight
+// children per node.
+template<class T>
+using Octree = PointTree<T, BoundingBox3, 8>;
+
+template<class T>
+using OctreeIterator = PointTreeIterator<T, BoundingBox3, 8>;
+
+}
+
+#endif
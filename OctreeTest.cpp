@@ -0,0 +1,92 @@
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "NearestTest.h"
+#include "Octree.h"
+
+using namespace Common;
+
+static Vector3 getRandomPoint()
+{
+	return Vector3(rand() % 1000 - 500, rand() % 1000 - 500, rand() % 200 - 100);
+}
+
+int octree(int argc, char** argv)
+{
+	BoundingBox3 boundary(Vector3(0, 0, 0), Vector3(500, 500, 100));
+	for(int i = 0; i < 20; i++) {
+		Octree<int> inserted(boundary);
+		std::vector<std::pair<int, Vector3>> items;
+		int numPoints = 10 + rand() % 20000;
+		for(int j = 0; j < numPoints; j++) {
+			items.push_back(std::make_pair(j, getRandomPoint()));
+			bool ret = inserted.insert(j, items[j].second);
+			assert(ret);
+		}
+
+		Octree<int> parallel(boundary, items, 4);
+
+		// move some points, mostly by a little
+		for(int j = 0; j < numPoints / 4; j++) {
+			int k = rand() % numPoints;
+			Vector3 newpos = rand() % 2 ? getRandomPoint() :
+				items[k].second + Vector3(rand() % 5 - 2, rand() % 5 - 2, rand() % 5 - 2);
+			if(!boundary.contains(newpos))
+				continue;
+			inserted.update(k, items[k].second, newpos);
+			parallel.update(k, items[k].second, newpos);
+			items[k].second = newpos;
+		}
+
+		std::vector<Vector3> positions;
+		for(auto& it : items)
+			positions.push_back(it.second);
+		for(int k = 0; k < 50; k++) {
+			BoundingBox3 area(getRandomPoint(), Vector3(rand() % 50, rand() % 50, rand() % 50));
+			Vector3 p = getRandomPoint();
+			unsigned int num = 1 + rand() % 10;
+			float radius = rand() % 50;
+
+			std::vector<int> expected;
+			for(auto& it : items) {
+				if(area.contains(it.second))
+					expected.push_back(it.first);
+			}
+
+			for(Octree<int>* t : { &inserted, &parallel }) {
+				auto found = t->query(area);
+				std::sort(found.begin(), found.end());
+				if(found != expected) {
+					printf("Octree: query returned %zu points, expected %zu\n",
+							found.size(), expected.size());
+					return 1;
+				}
+
+				if(!checkNearest("Octree", *t, positions, p, num, radius))
+					return 1;
+			}
+		}
+
+		for(auto& it : items) {
+			if(!inserted.deleteT(it.first, it.second)) {
+				printf("Octree: failed to delete %d\n", it.first);
+				return 1;
+			}
+		}
+
+		int counted = 0;
+		for(auto it = parallel.begin(); it != parallel.end(); ++it) {
+			counted++;
+		}
+
+		if(inserted.size() != 0 || counted != numPoints) {
+			printf("Octree: %d points left after deleting all, iterated over %d, expected %d\n",
+					inserted.size(), counted, numPoints);
+			return 1;
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
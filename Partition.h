@@ -1,6 +1,13 @@
 #ifndef COMMON_PARTITION_H
 #define COMMON_PARTITION_H
 
+#include <cassert>
+#include <cfloat>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 #include "Vector2.h"
 #include "Vector3.h"
 
@@ -16,6 +23,7 @@ struct AABB {
 	inline bool contains(const Vector2& p) const;
 	inline bool contains(const AABB& b) const;
 	inline bool intersects(const AABB& b) const;
+	inline float distance2(const Vector2& p) const; // zero if inside
 };
 
 inline std::ostream& operator<<(std::ostream& out, const AABB& r)
@@ -46,12 +54,51 @@ bool AABB::intersects(const AABB& b) const
 	return dx <= halfDimension.x + b.halfDimension.x && dy <= halfDimension.y + b.halfDimension.y;
 }
 
+float AABB::distance2(const Vector2& p) const
+{
+	float dx = std::max(0.0f, float(fabs(p.x - center.x)) - halfDimension.x);
+	float dy = std::max(0.0f, float(fabs(p.y - center.y)) - halfDimension.y);
+	return dx * dx + dy * dy;
+}
+
+// Helpers for k-nearest queries. The results are kept in a max-heap of
+// (squared distance, T) pairs in the caller's vector so that no other
+// memory is needed.
+template<typename T>
+struct NearestComp {
+	bool operator()(const std::pair<float, T>& lhs, const std::pair<float, T>& rhs) const
+	{
+		return lhs.first < rhs.first;
+	}
+};
+
+template<typename T>
+inline void pushNearest(std::vector<std::pair<float, T>>& heap, unsigned int k, float dist2, const T& t)
+{
+	if(heap.size() < k) {
+		heap.push_back(std::make_pair(dist2, t));
+		std::push_heap(heap.begin(), heap.end(), NearestComp<T>());
+	} else if(dist2 < heap.front().first) {
+		std::pop_heap(heap.begin(), heap.end(), NearestComp<T>());
+		heap.back() = std::make_pair(dist2, t);
+		std::push_heap(heap.begin(), heap.end(), NearestComp<T>());
+	}
+}
+
+// squared distance beyond which nothing can enter the heap any more
+template<typename T>
+inline float nearestBound(const std::vector<std::pair<float, T>>& heap, unsigned int k)
+{
+	return heap.size() < k ? FLT_MAX : heap.front().first;
+}
+
 struct BoundingBox3 {
 	Vector3 center;
 	Vector3 halfDimension;
 	BoundingBox3(const Vector3& c, const Vector3& hd) : center(c), halfDimension(hd) { }
 	inline bool contains(const Vector3& p) const;
 	inline bool intersects(const BoundingBox3& b) const;
+	inline float distance2(const Vector3& p) const; // zero if inside
 };
 
 inline std::ostream& operator<<(std::ostream& out, const BoundingBox3& r)
@@ -78,6 +125,14 @@ bool BoundingBox3::intersects(const BoundingBox3& b) const
 		dz <= halfDimension.z + b.halfDimension.z;
 }
 
+float BoundingBox3::distance2(const Vector3& p) const
+{
+	float dx = std::max(0.0f, float(fabs(p.x - center.x)) - halfDimension.x);
+	float dy = std::max(0.0f, float(fabs(p.y - center.y)) - halfDimension.y);
+	float dz = std::max(0.0f, float(fabs(p.z - center.z)) - halfDimension.z);
+	return dx * dx + dy * dy + dz * dz;
+}
+
 }
 
 #endif
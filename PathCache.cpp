@@ -0,0 +1,193 @@
+#include "PathCache.h"
+
+#include <cassert>
+
+#include <algorithm>
+
+namespace Common {
+
+PathCache::PathCache(const GridAStar& grid, unsigned int regionSize, unsigned int capacity)
+	: mGrid(grid),
+	mRegionSize(regionSize),
+	mRegionsX((grid.getWidth() + regionSize - 1) / regionSize),
+	mCapacity(capacity),
+	mVersion(grid.getVersion()),
+	mHits(0),
+	mMisses(0)
+{
+	assert(regionSize > 0);
+	assert(capacity > 0);
+}
+
+bool PathCache::findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path)
+{
+	checkVersion();
+	int startRegion = regionOf(start);
+	int goalRegion = regionOf(goal);
+	if(startRegion == goalRegion)
+		return mGrid.findPath(start, goal, path, mScratch);
+
+	unsigned long long key = (unsigned long long)startRegion << 32 | (unsigned int)goalRegion;
+	auto it = mIndex.find(key);
+	if(it != mIndex.end()) {
+		mEntries.splice(mEntries.begin(), mEntries, it->second);
+		decode(*it->second, mCached);
+		if(join(mCached, start, goal, path)) {
+			mHits++;
+			return true;
+		}
+	}
+
+	mMisses++;
+	if(!mGrid.findPath(start, goal, path, mScratch))
+		return false;
+	store(key, path);
+	return true;
+}
+
+void PathCache::tileChanged(int x, int y)
+{
+	assert(x >= 0 && y >= 0 && x < int(mGrid.getWidth()) && y < int(mGrid.getHeight()));
+	// the diagonal moves past the corners of the tile count too
+	std::vector<int> regions;
+	for(int dy = -1; dy <= 1; dy++) {
+		for(int dx = -1; dx <= 1; dx++) {
+			if(x + dx >= 0 && y + dy >= 0 && x + dx < int(mGrid.getWidth()) && y + dy < int(mGrid.getHeight()))
+				regions.push_back(regionOf(Point2(x + dx, y + dy)));
+		}
+	}
+
+	for(auto it = mEntries.begin(); it != mEntries.end(); ) {
+		bool passes = false;
+		for(auto r : regions) {
+			if(std::binary_search(it->regions.begin(), it->regions.end(), r)) {
+				passes = true;
+				break;
+			}
+		}
+		if(passes) {
+			mIndex.erase(it->key);
+			it = mEntries.erase(it);
+		} else {
+			++it;
+		}
+	}
+	mVersion = mGrid.getVersion();
+}
+
+void PathCache::clear()
+{
+	mEntries.clear();
+	mIndex.clear();
+}
+
+unsigned int PathCache::size() const
+{
+	return mEntries.size();
+}
+
+unsigned int PathCache::getHits() const
+{
+	return mHits;
+}
+
+unsigned int PathCache::getMisses() const
+{
+	return mMisses;
+}
+
+void PathCache::resetCounters()
+{
+	mHits = 0;
+	mMisses = 0;
+}
+
+int PathCache::regionOf(const Point2& p) const
+{
+	return p.y / mRegionSize * mRegionsX + p.x / mRegionSize;
+}
+
+void PathCache::decode(const Entry& e, std::vector<Point2>& path) const
+{
+	path.clear();
+	Point2 p = e.start;
+	path.push_back(p);
+	for(auto d : e.moves) {
+		p.x += GridAStar::MOVE_DX[d];
+		p.y += GridAStar::MOVE_DY[d];
+		path.push_back(p);
+	}
+}
+
+void PathCache::store(unsigned long long key, const std::vector<Point2>& path)
+{
+	auto it = mIndex.find(key);
+	if(it != mIndex.end()) {
+		mEntries.erase(it->second);
+		mIndex.erase(it);
+	} else if(mEntries.size() >= mCapacity) {
+		mIndex.erase(mEntries.back().key);
+		mEntries.pop_back();
+	}
+
+	mEntries.push_front(Entry());
+	Entry& e = mEntries.front();
+	e.key = key;
+	e.start = path.front();
+	e.moves.reserve(path.size() - 1);
+	for(unsigned int i = 1; i < path.size(); i++) {
+		int dx = path[i].x - path[i - 1].x;
+		int dy = path[i].y - path[i - 1].y;
+		unsigned char d = 0;
+		while(GridAStar::MOVE_DX[d] != dx || GridAStar::MOVE_DY[d] != dy)
+			d++;
+		e.moves.push_back(d);
+	}
+	for(auto& p : path)
+		e.regions.push_back(regionOf(p));
+	std::sort(e.regions.begin(), e.regions.end());
+	e.regions.erase(std::unique(e.regions.begin(), e.regions.end()), e.regions.end());
+	mIndex[key] = mEntries.begin();
+}
+
+bool PathCache::join(const std::vector<Point2>& cached, const Point2& start, const Point2& goal,
+		std::vector<Point2>& path)
+{
+	// leave the cached path where it last leaves the start region and join
+	// it where it first enters the goal region, so that the local searches
+	// stay short and don't double back along it
+	int startRegion = regionOf(start);
+	int goalRegion = regionOf(goal);
+	unsigned int first = 0;
+	for(unsigned int i = 0; i < cached.size(); i++) {
+		if(regionOf(cached[i]) == startRegion)
+			first = i;
+	}
+	unsigned int last = cached.size() - 1;
+	for(unsigned int i = first; i < cached.size(); i++) {
+		if(regionOf(cached[i]) == goalRegion) {
+			last = i;
+			break;
+		}
+	}
+
+	unsigned int maxExpansions = mRegionSize * mRegionSize;
+	if(!mGrid.findPath(start, cached[first], path, mScratch, maxExpansions))
+		return false;
+	path.insert(path.end(), cached.begin() + first + 1, cached.begin() + last);
+	if(!mGrid.findPath(cached[last], goal, mLocal, mScratch, maxExpansions))
+		return false;
+	path.insert(path.end(), mLocal.begin(), mLocal.end());
+	return true;
+}
+
+void PathCache::checkVersion()
+{
+	// changed without tileChanged()
+	if(mVersion != mGrid.getVersion()) {
+		clear();
+		mVersion = mGrid.getVersion();
+	}
+}
+
+}
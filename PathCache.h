@@ -0,0 +1,64 @@
+#ifndef COMMON_PATHCACHE_H
+#define COMMON_PATHCACHE_H
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+#include "GridAStar.h"
+
+namespace Common {
+
+// Least recently used cache of GridAStar paths, keyed by the square regions
+// the start and goal are in. A hit reuses the cached path between the two
+// regions and only searches locally to join it to the actual start and
+// goal, so the paths returned are valid but not always the shortest. The
+// local searches expand at most regionSize * regionSize cells each; if
+// they fail, the lookup is a miss.
+// Cached paths are dropped either all at once when the grid version has
+// changed, or per region by calling tileChanged() after each change to the
+// grid, which keeps the paths not passing through the region.
+class PathCache {
+	public:
+		PathCache(const GridAStar& grid, unsigned int regionSize = 8, unsigned int capacity = 256);
+		// like GridAStar::findPath(); start and goal in the same region
+		// are always searched directly
+		bool findPath(const Point2& start, const Point2& goal, std::vector<Point2>& path);
+		void tileChanged(int x, int y);
+		void clear();
+		unsigned int size() const;
+		unsigned int getHits() const;
+		unsigned int getMisses() const;
+		void resetCounters();
+
+	private:
+		struct Entry {
+			unsigned long long key;
+			Point2 start;
+			std::vector<unsigned char> moves; // directions from start on
+			std::vector<int> regions; // passed through, sorted
+		};
+		int regionOf(const Point2& p) const;
+		void decode(const Entry& e, std::vector<Point2>& path) const;
+		void store(unsigned long long key, const std::vector<Point2>& path);
+		bool join(const std::vector<Point2>& cached, const Point2& start, const Point2& goal,
+				std::vector<Point2>& path);
+		void checkVersion();
+
+		const GridAStar& mGrid;
+		unsigned int mRegionSize;
+		unsigned int mRegionsX;
+		unsigned int mCapacity;
+		unsigned int mVersion;
+		std::list<Entry> mEntries; // most recently used first
+		std::unordered_map<unsigned long long, std::list<Entry>::iterator> mIndex;
+		GridAStar::Scratch mScratch;
+		std::vector<Point2> mCached;
+		std::vector<Point2> mLocal;
+		unsigned int mHits;
+		unsigned int mMisses;
+};
+
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include "PathService.h"
+
+#include <algorithm>
+
+#include "Clock.h"
+
+namespace Common {
+
+bool PathService::Job::operator<(const Job& rhs) const
+{
+	// std::priority_queue puts the greatest first
+	if(priority != rhs.priority)
+		return priority < rhs.priority;
+	return seq > rhs.seq;
+}
+
+PathService::PathService(const GridAStar& grid, unsigned int threads)
+	: mGrid(grid),
+	mActive(0),
+	mNextId(0),
+	mQuit(false)
+{
+	for(unsigned int i = 0; i < threads; i++)
+		mWorkers.push_back(std::thread(&PathService::work, this));
+}
+
+PathService::~PathService()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWork.notify_all();
+	for(auto& w : mWorkers)
+		w.join();
+}
+
+unsigned int PathService::request(const Point2& start, const Point2& goal, int priority,
+		Method method)
+{
+	Job job;
+	job.priority = priority;
+	job.start = start;
+	job.goal = goal;
+	job.method = method;
+	return enqueue(job);
+}
+
+std::future<PathService::Result> PathService::requestFuture(const Point2& start, const Point2& goal,
+		int priority, Method method)
+{
+	Job job;
+	job.priority = priority;
+	job.start = start;
+	job.goal = goal;
+	job.method = method;
+	job.promise = std::make_shared<std::promise<Result>>();
+	std::future<Result> ret = job.promise->get_future();
+	enqueue(job);
+	return ret;
+}
+
+void PathService::poll(std::vector<Result>& out, unsigned int max)
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	unsigned int num = std::min<unsigned int>(max, mDone.size());
+	for(unsigned int i = 0; i < num; i++)
+		out.push_back(std::move(mDone[i]));
+	mDone.erase(mDone.begin(), mDone.begin() + num);
+}
+
+unsigned int PathService::update(double budget)
+{
+	double end = Clock::getTime() + budget;
+	unsigned int num = 0;
+	do {
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if(mQueue.empty())
+				break;
+			job = mQueue.top();
+			mQueue.pop();
+			mActive++;
+		}
+
+		solve(job, mScratch);
+		num++;
+	} while(Clock::getTime() < end);
+	return num;
+}
+
+void PathService::wait()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	if(mWorkers.empty()) {
+		lock.unlock();
+		while(update(1.0))
+			;
+		return;
+	}
+
+	mIdle.wait(lock, [this] { return mQueue.empty() && mActive == 0; });
+}
+
+unsigned int PathService::pending() const
+{
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mQueue.size() + mActive;
+}
+
+unsigned int PathService::enqueue(Job& job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		job.id = mNextId++;
+		job.seq = job.id;
+		mQueue.push(job);
+	}
+	mWork.notify_one();
+	return job.id;
+}
+
+void PathService::solve(const Job& job, GridAStar::Scratch& scratch)
+{
+	Result res;
+	res.id = job.id;
+	if(job.method == Method::JPS)
+		res.found = mGrid.findPathJPS(job.start, job.goal, res.path, scratch);
+	else
+		res.found = mGrid.findPath(job.start, job.goal, res.path, scratch);
+
+	if(job.promise)
+		job.promise->set_value(std::move(res));
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(!job.promise)
+		mDone.push_back(std::move(res));
+	mActive--;
+	if(mQueue.empty() && mActive == 0)
+		mIdle.notify_all();
+}
+
+void PathService::work()
+{
+	GridAStar::Scratch scratch;
+	while(1) {
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWork.wait(lock, [this] { return mQuit || !mQueue.empty(); });
+			if(mQuit)
+				return;
+			job = mQueue.top();
+			mQueue.pop();
+			mActive++;
+		}
+
+		solve(job, scratch);
+	}
+}
+
+}
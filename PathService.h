@@ -0,0 +1,83 @@
+#ifndef COMMON_PATHSERVICE_H
+#define COMMON_PATHSERVICE_H
+
+#include <climits>
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "GridAStar.h"
+
+namespace Common {
+
+// Solves queued path requests on a pool of worker threads, each with its
+// own GridAStar scratch buffer. Requests with a higher priority are solved
+// first, otherwise in order. Results are delivered either through a
+// completion queue drained with poll() at frame boundaries, or through a
+// future. With no worker threads, update() solves requests on the calling
+// thread within a time budget instead.
+// The grid must not be changed while requests are being solved; wait()
+// for the service to go idle first.
+class PathService {
+	public:
+		enum class Method {
+			AStar,
+			JPS
+		};
+		struct Result {
+			unsigned int id;
+			bool found;
+			std::vector<Point2> path;
+		};
+
+		PathService(const GridAStar& grid, unsigned int threads = 1);
+		~PathService(); // drops the requests not started yet
+		unsigned int request(const Point2& start, const Point2& goal, int priority = 0,
+				Method method = Method::AStar); // returns the id of the result
+		std::future<Result> requestFuture(const Point2& start, const Point2& goal, int priority = 0,
+				Method method = Method::AStar);
+		// moves at most max finished results to the end of out
+		void poll(std::vector<Result>& out, unsigned int max = UINT_MAX);
+		// solves queued requests on this thread until budget seconds have
+		// passed, at least one if any are queued - returns the number solved
+		unsigned int update(double budget);
+		void wait(); // until all requests are solved
+		unsigned int pending() const; // queued or being solved
+
+	private:
+		struct Job {
+			int priority;
+			unsigned int seq;
+			unsigned int id;
+			Point2 start;
+			Point2 goal;
+			Method method;
+			std::shared_ptr<std::promise<Result>> promise; // null for the completion queue
+			bool operator<(const Job& rhs) const;
+		};
+		unsigned int enqueue(Job& job);
+		void solve(const Job& job, GridAStar::Scratch& scratch);
+		void work();
+
+		const GridAStar& mGrid;
+		std::vector<std::thread> mWorkers;
+		GridAStar::Scratch mScratch; // for update()
+
+		mutable std::mutex mMutex;
+		std::condition_variable mWork;
+		std::condition_variable mIdle;
+		std::priority_queue<Job> mQueue;
+		std::vector<Result> mDone;
+		unsigned int mActive;
+		unsigned int mNextId;
+		bool mQuit;
+};
+
+}
+
+#endif
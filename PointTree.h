@@ -0,0 +1,620 @@
+#ifndef COMMON_POINTTREE_H
+#define COMMON_POINTTREE_H
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Partition.h"
+
+namespace Common {
+
+// Point tree that keeps all nodes in one array, FlatQuadTree and Octree
+// are this with AABB and four children and with BoundingBox3 and eight.
+// Nodes are addressed by index, the children of a node are stored next to
+// each other, merged away child blocks are reused and points are kept in
+// flat per-leaf buckets. Every axis of Box halves a node, so NumChildren
+// is two to the power of the number of axes; child i lies on the positive
+// side of axis a if bit a of i is set.
+// T must be comparable with operator==.
+
+template<class T, class Box, unsigned int NumChildren>
+class PointTree;
+
+// coordinate a of a position, x being 0
+inline float pointTreeAxis(const Vector2& v, int a)
+{
+	return a == 0 ? v.x : v.y;
+}
+
+inline float pointTreeAxis(const Vector3& v, int a)
+{
+	return a == 0 ? v.x : a == 1 ? v.y : v.z;
+}
+
+inline float& pointTreeAxis(Vector2& v, int a)
+{
+	return a == 0 ? v.x : v.y;
+}
+
+inline float& pointTreeAxis(Vector3& v, int a)
+{
+	return a == 0 ? v.x : a == 1 ? v.y : v.z;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+class PointTreeIterator {
+	public:
+		inline PointTreeIterator(PointTree<T, Box, NumChildren>& qt, bool atend);
+		inline bool operator!=(const PointTreeIterator& other) const;
+		inline T operator*();
+		inline PointTreeIterator& operator++();
+
+	private:
+		inline PointTreeIterator& next();
+
+		PointTree<T, Box, NumChildren>* mQT;
+		unsigned int mNode = 0;
+		unsigned int mIndex = 0;
+		bool mEnd = false;
+};
+
+template<class T, class Box, unsigned int NumChildren>
+class PointTree {
+	public:
+		typedef decltype(Box::center) Vec;
+
+		inline PointTree(const Box& boundary);
+		// bulk load - points outside the boundary are ignored
+		inline PointTree(const Box& boundary, const std::vector<std::pair<T, Vec>>& points,
+				unsigned int threads = 1);
+		inline bool insert(T& t, const Vec& p); // invalidates all iterators
+		inline bool deleteT(T& t, const Vec& p); // invalidates all iterators
+		inline bool update(T& t, const Vec& oldpos, const Vec& newpos); // invalidates all iterators
+		inline void clear();
+		inline std::vector<T> query(const Box& area) const;
+		inline void query(const Box& area, std::vector<T>& out) const; // appends to out
+		template<typename F>
+		inline void query(const Box& area, F&& visitor) const; // calls visitor(const T&), no allocations
+		// k nearest elements to p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void nearest(const Vec& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		// elements within radius of p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void withinRadius(const Vec& p, float radius, std::vector<std::pair<float, T>>& out) const;
+		inline unsigned int size() const;
+		inline PointTreeIterator<T, Box, NumChildren> begin();
+		inline PointTreeIterator<T, Box, NumChildren> end();
+
+	private:
+		struct Node {
+			Node(const Box& b, int p) : boundary(b), parent(p), children(-1) { }
+			Box boundary;
+			int parent;
+			int children; // index of the first of NumChildren consecutive children, -1 for leaves
+		};
+
+		struct Point {
+			Point(const T& t_, const Vec& p) : t(t_), pos(p) { }
+			T t;
+			Vec pos;
+		};
+
+		template<typename F>
+		inline void queryNode(int node, const Box& area, F& visitor) const;
+		inline void nearestNode(int node, const Vec& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		inline void withinRadiusNode(int node, const Vec& p, float radius2, std::vector<std::pair<float, T>>& out) const;
+		typedef typename std::vector<Point>::iterator BuildIterator;
+		inline void build(int node, BuildIterator begin, BuildIterator end, unsigned int threads);
+		inline void adopt(int node, PointTree& subtree);
+		inline bool canSubdivide(int node) const;
+		inline void subdivide(int node);
+		inline void mergeUp(int node);
+		inline int findPoint(int leaf, const T& t) const;
+		inline void addToLeaf(int leaf, const T& t, const Vec& p);
+		inline void removeFromLeaf(int leaf, int index);
+		inline int childIndex(int node, const Vec& p) const;
+		inline int findLeaf(const Vec& p, int from = 0) const;
+		static const unsigned int NUM_AXES = NumChildren == 4 ? 2 : 3;
+		static const unsigned int NODE_CAPACITY = NumChildren;
+		static const unsigned int PARALLEL_BUILD_MIN = 4096;
+		constexpr static const float MIN_DIMENSION = 8.0f;
+		std::vector<Node> mNodes;
+		std::vector<std::vector<Point>> mBuckets; // indexed by node, may be larger than mNodes
+		std::vector<int> mFreeBlocks; // first indices of merged away child blocks
+		unsigned int mSize;
+
+		static_assert(NumChildren == 1u << NUM_AXES && sizeof(Vec) == NUM_AXES * sizeof(float),
+				"PointTree needs four children in 2D or eight in 3D");
+
+		friend class PointTreeIterator<T, Box, NumChildren>;
+};
+
+template<class T, class Box, unsigned int NumChildren>
+PointTree<T, Box, NumChildren>::PointTree(const Box& boundary)
+	: mSize(0)
+{
+	mNodes.push_back(Node(boundary, -1));
+	mBuckets.resize(1);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+PointTree<T, Box, NumChildren>::PointTree(const Box& boundary, const std::vector<std::pair<T, Vec>>& points,
+		unsigned int threads)
+	: PointTree(boundary)
+{
+	std::vector<Point> items;
+	items.reserve(points.size());
+	for(auto& p : points) {
+		if(mNodes[0].boundary.contains(p.second))
+			items.push_back(Point(p.first, p.second));
+	}
+
+	mSize = items.size();
+	build(0, items.begin(), items.end(), threads);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+bool PointTree<T, Box, NumChildren>::insert(T& t, const Vec& p)
+{
+	if(!mNodes[0].boundary.contains(p)) {
+		return false;
+	}
+
+	addToLeaf(findLeaf(p), t, p);
+	return true;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+bool PointTree<T, Box, NumChildren>::deleteT(T& t, const Vec& p)
+{
+	if(!mNodes[0].boundary.contains(p)) {
+		return false;
+	}
+
+	int leaf = findLeaf(p);
+	int index = findPoint(leaf, t);
+	if(index == -1) {
+		return false;
+	}
+
+	removeFromLeaf(leaf, index);
+	return true;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+bool PointTree<T, Box, NumChildren>::update(T& t, const Vec& oldpos, const Vec& newpos)
+{
+	if(!mNodes[0].boundary.contains(newpos)) {
+		std::cout << "PointTree: failed to insert to position " << newpos << "\n";
+		assert(0);
+		return false;
+	}
+
+	// walk down the old path, noting where the new position would branch off -
+	// that's the nearest common ancestor and as far up as the element needs to move
+	int leaf = 0;
+	int branch = -1;
+	while(mNodes[leaf].children != -1) {
+		int next = childIndex(leaf, oldpos);
+		if(branch == -1 && childIndex(leaf, newpos) != next)
+			branch = leaf;
+		leaf = next;
+	}
+
+	int index = findPoint(leaf, t);
+	if(index == -1) {
+		std::cout << "PointTree: failed to delete from position " << oldpos << "\n";
+		assert(0);
+		return false;
+	}
+
+	if(branch == -1) {
+		mBuckets[leaf][index].pos = newpos;
+		return true;
+	}
+
+	// add before removing so that merging can't free the branch node
+	addToLeaf(findLeaf(newpos, branch), t, newpos);
+	removeFromLeaf(leaf, index);
+	return true;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::clear()
+{
+	// buckets are kept around so that their memory can be reused
+	mNodes.erase(mNodes.begin() + 1, mNodes.end());
+	mNodes[0].children = -1;
+	for(auto& b : mBuckets)
+		b.clear();
+	mFreeBlocks.clear();
+	mSize = 0;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+std::vector<T> PointTree<T, Box, NumChildren>::query(const Box& area) const
+{
+	std::vector<T> points;
+	query(area, points);
+	return points;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::query(const Box& area, std::vector<T>& out) const
+{
+	query(area, [&out] (const T& t) { out.push_back(t); });
+}
+
+template<class T, class Box, unsigned int NumChildren>
+template<typename F>
+void PointTree<T, Box, NumChildren>::query(const Box& area, F&& visitor) const
+{
+	queryNode(0, area, visitor);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::nearest(const Vec& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	if(k == 0)
+		return;
+
+	nearestNode(0, p, k, out);
+	std::sort_heap(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::withinRadius(const Vec& p, float radius, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	withinRadiusNode(0, p, radius * radius, out);
+	std::sort(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T, class Box, unsigned int NumChildren>
+unsigned int PointTree<T, Box, NumChildren>::size() const
+{
+	return mSize;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+template<typename F>
+void PointTree<T, Box, NumChildren>::queryNode(int node, const Box& area, F& visitor) const
+{
+	const Node& n = mNodes[node];
+	if(!n.boundary.intersects(area))
+		return;
+
+	if(n.children == -1) {
+		for(auto& p : mBuckets[node]) {
+			if(area.contains(p.pos)) {
+				visitor(p.t);
+			}
+		}
+		return;
+	}
+
+	for(unsigned int i = 0; i < NumChildren; i++)
+		queryNode(n.children + i, area, visitor);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::build(int node, BuildIterator begin, BuildIterator end, unsigned int threads)
+{
+	if((unsigned int)(end - begin) <= NODE_CAPACITY || !canSubdivide(node)) {
+		mBuckets[node].assign(begin, end);
+		return;
+	}
+
+	subdivide(node);
+	int first = mNodes[node].children;
+
+	// partition in childIndex() order: by the last axis, then within each
+	// half by the one before and so on
+	const Vec c = mNodes[node].boundary.center;
+	BuildIterator bounds[NumChildren + 1];
+	bounds[0] = begin;
+	bounds[NumChildren] = end;
+	for(int a = NUM_AXES - 1; a >= 0; a--) {
+		unsigned int step = 1 << a;
+		float split = pointTreeAxis(c, a);
+		for(unsigned int i = 0; i < NumChildren; i += 2 * step)
+			bounds[i + step] = std::partition(bounds[i], bounds[i + 2 * step],
+					[a, split] (const Point& p) { return pointTreeAxis(p.pos, a) <= split; });
+	}
+
+	if(threads > 1 && (unsigned int)(end - begin) >= PARALLEL_BUILD_MIN) {
+		// build the subtrees into trees of their own and splice them in afterwards
+		std::vector<PointTree> subtrees;
+		subtrees.reserve(NumChildren);
+		for(unsigned int i = 0; i < NumChildren; i++)
+			subtrees.emplace_back(mNodes[first + i].boundary);
+
+		std::thread workers[NumChildren];
+		for(unsigned int i = 0; i < NumChildren; i++)
+			workers[i] = std::thread(&PointTree::build, &subtrees[i], 0,
+					bounds[i], bounds[i + 1], (threads + NumChildren - 1) / NumChildren);
+		for(auto& w : workers)
+			w.join();
+
+		for(unsigned int i = 0; i < NumChildren; i++)
+			adopt(first + i, subtrees[i]);
+	} else {
+		for(unsigned int i = 0; i < NumChildren; i++)
+			build(first + i, bounds[i], bounds[i + 1], 1);
+	}
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::adopt(int node, PointTree& subtree)
+{
+	// the subtree root maps to node, everything else is appended
+	int base = mNodes.size() - 1;
+	auto remap = [&] (int i) { return i == 0 ? node : base + i; };
+
+	std::swap(mBuckets[node], subtree.mBuckets[0]);
+	if(subtree.mNodes[0].children != -1)
+		mNodes[node].children = remap(subtree.mNodes[0].children);
+
+	for(unsigned int i = 1; i < subtree.mNodes.size(); i++) {
+		Node n = subtree.mNodes[i];
+		n.parent = remap(n.parent);
+		if(n.children != -1)
+			n.children = remap(n.children);
+		mNodes.push_back(n);
+	}
+
+	if(mBuckets.size() < mNodes.size())
+		mBuckets.resize(mNodes.size());
+	for(unsigned int i = 1; i < subtree.mNodes.size(); i++)
+		std::swap(mBuckets[base + i], subtree.mBuckets[i]);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::nearestNode(int node, const Vec& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	const Node& n = mNodes[node];
+	if(n.children == -1) {
+		for(auto& pt : mBuckets[node]) {
+			pushNearest(out, k, p.distance2(pt.pos), pt.t);
+		}
+		return;
+	}
+
+	// descend into the nearest child first so that the others are more likely pruned
+	float dists[NumChildren];
+	int order[NumChildren];
+	for(unsigned int i = 0; i < NumChildren; i++) {
+		dists[i] = mNodes[n.children + i].boundary.distance2(p);
+		order[i] = i;
+	}
+	std::sort(order, order + NumChildren, [&dists] (int a, int b) { return dists[a] < dists[b]; });
+
+	for(unsigned int i = 0; i < NumChildren; i++) {
+		if(dists[order[i]] > nearestBound(out, k))
+			break;
+		nearestNode(n.children + order[i], p, k, out);
+	}
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::withinRadiusNode(int node, const Vec& p, float radius2, std::vector<std::pair<float, T>>& out) const
+{
+	const Node& n = mNodes[node];
+	if(n.boundary.distance2(p) > radius2)
+		return;
+
+	if(n.children == -1) {
+		for(auto& pt : mBuckets[node]) {
+			float d2 = p.distance2(pt.pos);
+			if(d2 <= radius2) {
+				out.push_back(std::make_pair(d2, pt.t));
+			}
+		}
+		return;
+	}
+
+	for(unsigned int i = 0; i < NumChildren; i++)
+		withinRadiusNode(n.children + i, p, radius2, out);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+bool PointTree<T, Box, NumChildren>::canSubdivide(int node) const
+{
+	const Box& b = mNodes[node].boundary;
+	for(unsigned int a = 0; a < NUM_AXES; a++) {
+		if(pointTreeAxis(b.halfDimension, a) * 2.0f <= MIN_DIMENSION)
+			return false;
+	}
+	return true;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::subdivide(int node)
+{
+	assert(mNodes[node].children == -1);
+	Box b = mNodes[node].boundary;
+	Vec half = b.halfDimension * 0.5f;
+
+	int first;
+	if(!mFreeBlocks.empty()) {
+		first = mFreeBlocks.back();
+		mFreeBlocks.pop_back();
+	} else {
+		first = mNodes.size();
+		mNodes.insert(mNodes.end(), NumChildren, Node(b, node));
+		if(mBuckets.size() < mNodes.size())
+			mBuckets.resize(mNodes.size());
+	}
+
+	// must match childIndex()
+	for(unsigned int i = 0; i < NumChildren; i++) {
+		Vec center = b.center;
+		for(unsigned int a = 0; a < NUM_AXES; a++)
+			pointTreeAxis(center, a) += i & (1 << a) ? pointTreeAxis(half, a) : -pointTreeAxis(half, a);
+		mNodes[first + i] = Node(Box(center, half), node);
+	}
+
+	mNodes[node].children = first;
+
+	for(auto& p : mBuckets[node]) {
+		mBuckets[childIndex(node, p.pos)].push_back(p);
+	}
+	mBuckets[node].clear();
+}
+
+template<class T, class Box, unsigned int NumChildren>
+int PointTree<T, Box, NumChildren>::childIndex(int node, const Vec& p) const
+{
+	const Node& n = mNodes[node];
+	assert(n.children != -1);
+	// points on the center lines or planes go to the negative side
+	int i = 0;
+	for(unsigned int a = 0; a < NUM_AXES; a++) {
+		if(pointTreeAxis(p, a) > pointTreeAxis(n.boundary.center, a))
+			i |= 1 << a;
+	}
+	return n.children + i;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+int PointTree<T, Box, NumChildren>::findLeaf(const Vec& p, int from) const
+{
+	int node = from;
+	while(mNodes[node].children != -1)
+		node = childIndex(node, p);
+	return node;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+int PointTree<T, Box, NumChildren>::findPoint(int leaf, const T& t) const
+{
+	auto& bucket = mBuckets[leaf];
+	for(unsigned int i = 0; i < bucket.size(); i++) {
+		if(bucket[i].t == t)
+			return i;
+	}
+	return -1;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::addToLeaf(int leaf, const T& t, const Vec& p)
+{
+	mBuckets[leaf].push_back(Point(t, p));
+	mSize++;
+
+	// a split may send all points to the same child so keep going
+	// until the leaf holding the new point is within capacity
+	while(mBuckets[leaf].size() > NODE_CAPACITY && canSubdivide(leaf)) {
+		subdivide(leaf);
+		leaf = childIndex(leaf, p);
+	}
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::removeFromLeaf(int leaf, int index)
+{
+	auto& bucket = mBuckets[leaf];
+	bucket[index] = bucket.back();
+	bucket.pop_back();
+	mSize--;
+	mergeUp(mNodes[leaf].parent);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+void PointTree<T, Box, NumChildren>::mergeUp(int node)
+{
+	// pull the children back in once they're leaves that fit in their parent
+	while(node != -1) {
+		int first = mNodes[node].children;
+		unsigned int num = 0;
+		for(int i = first; i < first + int(NumChildren); i++) {
+			if(mNodes[i].children != -1)
+				return;
+			num += mBuckets[i].size();
+		}
+
+		if(num > NODE_CAPACITY)
+			return;
+
+		for(int i = first; i < first + int(NumChildren); i++) {
+			mBuckets[node].insert(mBuckets[node].end(), mBuckets[i].begin(), mBuckets[i].end());
+			mBuckets[i].clear();
+		}
+		mNodes[node].children = -1;
+		mFreeBlocks.push_back(first);
+		node = mNodes[node].parent;
+	}
+}
+
+template<class T, class Box, unsigned int NumChildren>
+PointTreeIterator<T, Box, NumChildren>::PointTreeIterator(PointTree<T, Box, NumChildren>& qt, bool atend)
+	: mQT(&qt)
+{
+	if(atend) {
+		mEnd = true;
+	} else {
+		// ensure valid iterator
+		next();
+	}
+}
+
+template<class T, class Box, unsigned int NumChildren>
+bool PointTreeIterator<T, Box, NumChildren>::operator!=(const PointTreeIterator& other) const
+{
+	return mEnd != other.mEnd;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+PointTreeIterator<T, Box, NumChildren>& PointTreeIterator<T, Box, NumChildren>::operator++()
+{
+	assert(!mEnd);
+	++mIndex;
+
+	return next();
+}
+
+template<class T, class Box, unsigned int NumChildren>
+inline PointTreeIterator<T, Box, NumChildren>& PointTreeIterator<T, Box, NumChildren>::next()
+{
+	assert(!mEnd);
+
+	while(mIndex >= mQT->mBuckets[mNode].size()) {
+		mIndex = 0;
+		if(++mNode >= mQT->mNodes.size()) {
+			// end
+			mEnd = true;
+			return *this;
+		}
+	}
+
+	return *this;
+}
+
+template<class T, class Box, unsigned int NumChildren>
+PointTreeIterator<T, Box, NumChildren> PointTree<T, Box, NumChildren>::begin()
+{
+	return PointTreeIterator<T, Box, NumChildren>(*this, false);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+PointTreeIterator<T, Box, NumChildren> PointTree<T, Box, NumChildren>::end()
+{
+	return PointTreeIterator<T, Box, NumChildren>(*this, true);
+}
+
+template<class T, class Box, unsigned int NumChildren>
+T PointTreeIterator<T, Box, NumChildren>::operator*()
+{
+	return mQT->mBuckets[mNode][mIndex].t;
+}
+
+}
+
+#endif
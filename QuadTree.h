@@ -4,9 +4,12 @@
 #include <cassert>
 #include <cmath>
 
+#include <algorithm>
 #include <iostream>
 #include <map>
 #include <queue>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "Partition.h"
@@ -36,24 +39,44 @@ template<class T>
 class QuadTree {
 	public:
 		inline QuadTree(const AABB& boundary);
+		// bulk load - points outside the boundary are ignored
+		inline QuadTree(const AABB& boundary, const std::vector<std::pair<T, Vector2>>& points,
+				unsigned int threads = 1);
 		inline ~QuadTree();
 		inline bool insert(T& t, const Vector2& p); // invalidates all iterators
 		inline bool deleteT(T& t, const Vector2& p); // invalidates all iterators
-		inline bool update(T& t, const Vector2& oldpos, const Vector2& newpos); // invalidates all iterators - slow
+		inline bool update(T& t, const Vector2& oldpos, const Vector2& newpos); // invalidates all iterators
 		inline void clear();
 		inline std::vector<T> query(const AABB& area) const;
+		inline void query(const AABB& area, std::vector<T>& out) const; // appends to out
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const; // calls visitor(const T&), no allocations
+		// k nearest elements to p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		// elements within radius of p as (squared distance, T) pairs sorted by distance,
+		// out is overwritten
+		inline void withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const;
 		inline unsigned int size() const;
 		inline QTIterator<T> begin();
 		inline QTIterator<T> end();
 
 	private:
+		typedef typename std::vector<std::pair<T, Vector2>>::iterator BuildIterator;
+		inline QuadTree(const AABB& boundary, QuadTree* parent);
+		inline void build(BuildIterator begin, BuildIterator end, unsigned int threads);
 		inline void subdivide();
+		inline bool tryMerge();
+		inline void nearestNode(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const;
+		inline void withinRadiusNode(const Vector2& p, float radius2, std::vector<std::pair<float, T>>& out) const;
 		inline bool updateClean(T& t, const Vector2& oldpos, const Vector2& newpos);
 		inline QuadTree<T>* find(T& t, const Vector2& pos);
 		static const unsigned int NODE_CAPACITY = 4;
+		static const unsigned int PARALLEL_BUILD_MIN = 4096;
 		constexpr static const float MIN_DIMENSION = 8.0f;
 		AABB mBoundary;
 		std::map<T, Vector2> mPoints;
+		QuadTree* mParent;
 		QuadTree* mNW;
 		QuadTree* mNE;
 		QuadTree* mSW;
@@ -64,7 +87,14 @@ class QuadTree {
 
 template<class T>
 QuadTree<T>::QuadTree(const AABB& boundary)
+	: QuadTree(boundary, nullptr)
+{
+}
+
+template<class T>
+QuadTree<T>::QuadTree(const AABB& boundary, QuadTree* parent)
 	: mBoundary(boundary),
+	mParent(parent),
 	mNW(nullptr),
 	mNE(nullptr),
 	mSW(nullptr),
@@ -72,6 +102,21 @@ QuadTree<T>::QuadTree(const AABB& boundary)
 {
 }
 
+template<class T>
+QuadTree<T>::QuadTree(const AABB& boundary, const std::vector<std::pair<T, Vector2>>& points,
+		unsigned int threads)
+	: QuadTree(boundary, nullptr)
+{
+	std::vector<std::pair<T, Vector2>> items;
+	items.reserve(points.size());
+	for(auto& p : points) {
+		if(mBoundary.contains(p.second))
+			items.push_back(p);
+	}
+
+	build(items.begin(), items.end(), threads);
+}
+
 template<class T>
 QuadTree<T>::~QuadTree()
 {
@@ -125,10 +170,11 @@ bool QuadTree<T>::deleteT(T& t, const Vector2& p)
 		return false;
 	}
 
-	if(mNW->deleteT(t, p)) return true;
-	if(mNE->deleteT(t, p)) return true;
-	if(mSW->deleteT(t, p)) return true;
-	if(mSE->deleteT(t, p)) return true;
+	if(mNW->deleteT(t, p) || mNE->deleteT(t, p) ||
+			mSW->deleteT(t, p) || mSE->deleteT(t, p)) {
+		tryMerge();
+		return true;
+	}
 
 	return false;
 }
@@ -157,41 +203,105 @@ template<class T>
 std::vector<T> QuadTree<T>::query(const AABB& area) const
 {
 	std::vector<T> points;
+	query(area, points);
+	return points;
+}
+
+template<class T>
+void QuadTree<T>::query(const AABB& area, std::vector<T>& out) const
+{
+	query(area, [&out] (const T& t) { out.push_back(t); });
+}
 
+template<class T>
+template<typename F>
+void QuadTree<T>::query(const AABB& area, F&& visitor) const
+{
 	if(!mBoundary.intersects(area))
-		return points;
+		return;
 
 	for(auto& p : mPoints) {
 		if(area.contains(p.second)) {
-			points.push_back(p.first);
+			visitor(p.first);
 		}
 	}
 
 	if(mNW == nullptr) {
-		return points;
+		return;
+	}
+
+	mNW->query(area, visitor);
+	mNE->query(area, visitor);
+	mSW->query(area, visitor);
+	mSE->query(area, visitor);
+}
+
+template<class T>
+void QuadTree<T>::nearest(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	if(k == 0)
+		return;
+
+	nearestNode(p, k, out);
+	std::sort_heap(out.begin(), out.end(), NearestComp<T>());
+}
+
+template<class T>
+void QuadTree<T>::nearestNode(const Vector2& p, unsigned int k, std::vector<std::pair<float, T>>& out) const
+{
+	for(auto& pt : mPoints) {
+		pushNearest(out, k, p.distance2(pt.second), pt.first);
 	}
 
-	{
-		std::vector<T> morepoints = mNW->query(area);
-		points.insert(points.end(), morepoints.begin(), morepoints.end());
+	if(mNW == nullptr) {
+		return;
 	}
 
-	{
-		std::vector<T> morepoints = mNE->query(area);
-		points.insert(points.end(), morepoints.begin(), morepoints.end());
+	// descend into the nearest child first so that the others are more likely pruned
+	const QuadTree* children[] = { mNW, mNE, mSW, mSE };
+	float dists[4];
+	int order[4] = { 0, 1, 2, 3 };
+	for(int i = 0; i < 4; i++)
+		dists[i] = children[i]->mBoundary.distance2(p);
+	std::sort(order, order + 4, [&dists] (int a, int b) { return dists[a] < dists[b]; });
+
+	for(int i = 0; i < 4; i++) {
+		if(dists[order[i]] > nearestBound(out, k))
+			break;
+		children[order[i]]->nearestNode(p, k, out);
 	}
+}
+
+template<class T>
+void QuadTree<T>::withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, T>>& out) const
+{
+	out.clear();
+	withinRadiusNode(p, radius * radius, out);
+	std::sort(out.begin(), out.end(), NearestComp<T>());
+}
 
-	{
-		std::vector<T> morepoints = mSW->query(area);
-		points.insert(points.end(), morepoints.begin(), morepoints.end());
+template<class T>
+void QuadTree<T>::withinRadiusNode(const Vector2& p, float radius2, std::vector<std::pair<float, T>>& out) const
+{
+	if(mBoundary.distance2(p) > radius2)
+		return;
+
+	for(auto& pt : mPoints) {
+		float d2 = p.distance2(pt.second);
+		if(d2 <= radius2) {
+			out.push_back(std::make_pair(d2, pt.first));
+		}
 	}
 
-	{
-		std::vector<T> morepoints = mSE->query(area);
-		points.insert(points.end(), morepoints.begin(), morepoints.end());
+	if(mNW == nullptr) {
+		return;
 	}
 
-	return points;
+	mNW->withinRadiusNode(p, radius2, out);
+	mNE->withinRadiusNode(p, radius2, out);
+	mSW->withinRadiusNode(p, radius2, out);
+	mSE->withinRadiusNode(p, radius2, out);
 }
 
 template<class T>
@@ -220,34 +330,109 @@ void QuadTree<T>::subdivide()
 	float my = mBoundary.halfDimension.y * 0.5f;
 	mNW = new QuadTree(AABB(Vector2(mBoundary.center.x - mx,
 					mBoundary.center.y - my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), this);
 	mNE = new QuadTree(AABB(Vector2(mBoundary.center.x + mx,
 					mBoundary.center.y - my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), this);
 	mSW = new QuadTree(AABB(Vector2(mBoundary.center.x - mx,
 					mBoundary.center.y + my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), this);
 	mSE = new QuadTree(AABB(Vector2(mBoundary.center.x + mx,
 					mBoundary.center.y + my),
-				Vector2(mx, my)));
+				Vector2(mx, my)), this);
+}
+
+template<class T>
+void QuadTree<T>::build(BuildIterator begin, BuildIterator end, unsigned int threads)
+{
+	if((unsigned int)(end - begin) <= NODE_CAPACITY || mBoundary.halfDimension.x * 2.0f <= MIN_DIMENSION ||
+			mBoundary.halfDimension.y * 2.0f <= MIN_DIMENSION) {
+		mPoints.insert(begin, end);
+		return;
+	}
+
+	subdivide();
+
+	// same child preference as insert()
+	QuadTree* children[] = { mNW, mNE, mSW, mSE };
+	BuildIterator bounds[5];
+	bounds[0] = begin;
+	for(int i = 0; i < 4; i++) {
+		const AABB& b = children[i]->mBoundary;
+		bounds[i + 1] = std::partition(bounds[i], end,
+				[&b] (const std::pair<T, Vector2>& p) { return b.contains(p.second); });
+	}
+	mPoints.insert(bounds[4], end);
+
+	if(threads > 1 && (unsigned int)(end - begin) >= PARALLEL_BUILD_MIN) {
+		std::thread workers[4];
+		for(int i = 0; i < 4; i++)
+			workers[i] = std::thread(&QuadTree<T>::build, children[i],
+					bounds[i], bounds[i + 1], (threads + 3) / 4);
+		for(auto& w : workers)
+			w.join();
+	} else {
+		for(int i = 0; i < 4; i++)
+			children[i]->build(bounds[i], bounds[i + 1], 1);
+	}
+}
+
+template<class T>
+bool QuadTree<T>::tryMerge()
+{
+	// pull the children back in once they're leaves that fit in this node
+	if(!mNW || mNW->mNW || mNE->mNW || mSW->mNW || mSE->mNW)
+		return false;
+
+	if(mPoints.size() + mNW->mPoints.size() + mNE->mPoints.size() +
+			mSW->mPoints.size() + mSE->mPoints.size() > NODE_CAPACITY)
+		return false;
+
+	QuadTree* children[] = { mNW, mNE, mSW, mSE };
+	for(auto c : children) {
+		mPoints.insert(c->mPoints.begin(), c->mPoints.end());
+		delete c;
+	}
+
+	mNW = mNE = mSW = mSE = nullptr;
+	return true;
 }
 
 template<class T>
 bool QuadTree<T>::updateClean(T& t, const Vector2& oldpos, const Vector2& newpos)
 {
-	if(!deleteT(t, oldpos)) {
+	QuadTree* node = find(t, oldpos);
+	if(!node) {
 		std::cout << "QuadTree: failed to delete from position " << oldpos << "\n";
 		assert(0);
 		return false;
 	}
 
-	if(!insert(t, newpos)) {
+	if(node->mBoundary.contains(newpos)) {
+		node->mPoints[t] = newpos;
+		return true;
+	}
+
+	// only climb as far as the nearest node that contains the new position
+	QuadTree* ancestor = node->mParent;
+	while(ancestor && !ancestor->mBoundary.contains(newpos))
+		ancestor = ancestor->mParent;
+
+	if(!ancestor) {
 		std::cout << "QuadTree: failed to insert to position " << newpos << "\n";
 		assert(0);
 		return false;
 	}
 
-	return true;
+	node->mPoints.erase(t);
+	bool inserted = ancestor->insert(t, newpos);
+	assert(inserted);
+
+	QuadTree* n = node->mNW ? node : node->mParent;
+	while(n && n->tryMerge())
+		n = n->mParent;
+
+	return inserted;
 }
 
 template<class T>
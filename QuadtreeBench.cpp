@@ -0,0 +1,81 @@
+#include <stdlib.h>
+
+#include "Clock.h"
+#include "QuadTree.h"
+#include "LineQuadTree.h"
+#include "FlatQuadTree.h"
+
+using namespace Common;
+
+static const int NUM_POINTS = 20000;
+static const int NUM_QUERIES = 50000;
+
+static Vector2 getRandomPoint()
+{
+	return Vector2(rand() % 1000 - 500, rand() % 1000 - 500);
+}
+
+template<typename Tree>
+static bool benchQuery(const char* name, Tree& tree, const std::vector<Vector2>& queries)
+{
+	unsigned long total1 = 0, total2 = 0, total3 = 0;
+	std::vector<int> buf;
+
+	double t0 = Clock::getTime();
+	for(auto& q : queries) {
+		total1 += tree.query(AABB(q, Vector2(10, 10))).size();
+	}
+
+	double t1 = Clock::getTime();
+	for(auto& q : queries) {
+		buf.clear();
+		tree.query(AABB(q, Vector2(10, 10)), buf);
+		total2 += buf.size();
+	}
+
+	double t2 = Clock::getTime();
+	for(auto& q : queries) {
+		tree.query(AABB(q, Vector2(10, 10)), [&] (int) { total3++; });
+	}
+
+	double t3 = Clock::getTime();
+
+	printf("%-14s %d queries: vector %.3f s, buffer %.3f s, visitor %.3f s\n",
+			name, (int)queries.size(), t1 - t0, t2 - t1, t3 - t2);
+
+	if(total1 != total2 || total1 != total3) {
+		printf("%s: result counts differ: %lu %lu %lu\n", name, total1, total2, total3);
+		return false;
+	}
+	return true;
+}
+
+int quadtree_query(int argc, char** argv)
+{
+	AABB boundary(Vector2(0, 0), Vector2(500, 500));
+	QuadTree<int> qt(boundary);
+	FlatQuadTree<int> fqt(boundary);
+	LineQuadTree<int> lqt(boundary);
+	LineQuadTree<int> loose(boundary, 2.0f);
+
+	for(int i = 0; i < NUM_POINTS; i++) {
+		Vector2 p = getRandomPoint();
+		qt.insert(i, p);
+		fqt.insert(i, p);
+		AABB l(p, Vector2(rand() % 4, rand() % 4));
+		lqt.insert(i, l);
+		loose.insert(i, l);
+	}
+
+	std::vector<Vector2> queries;
+	for(int i = 0; i < NUM_QUERIES; i++) {
+		queries.push_back(getRandomPoint());
+	}
+
+	bool ok = true;
+	ok = benchQuery("QuadTree", qt, queries) && ok;
+	ok = benchQuery("FlatQuadTree", fqt, queries) && ok;
+	ok = benchQuery("LineQuadTree", lqt, queries) && ok;
+	ok = benchQuery("Loose LQT", loose, queries) && ok;
+	return ok ? 0 : 1;
+}
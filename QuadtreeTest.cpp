@@ -1,7 +1,12 @@
 #include <stdlib.h>
 
+#include <algorithm>
+
 #include "QuadTree.h"
 #include "LineQuadTree.h"
+#include "FlatQuadTree.h"
+#include "Math.h"
+#include "NearestTest.h"
 
 using namespace Common;
 
@@ -89,3 +94,273 @@ int linequadtree(int argc, char** argv)
 }
 
 
+
+int flatquadtree(int argc, char** argv)
+{
+	for(int i = 0; i < 1000; i++) {
+		QuadTree<int> ref(AABB(Vector2(0, 0), Vector2(500, 500)));
+		FlatQuadTree<int> points(AABB(Vector2(0, 0), Vector2(500, 500)));
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			ref.insert(j, positions[j]);
+			bool ret = points.insert(j, positions[j]);
+			assert(ret);
+		}
+
+		for(int j = 0; j < numPoints; j += 3) {
+			bool ret = points.deleteT(j, positions[j]);
+			ref.deleteT(j, positions[j]);
+			if(!ret) {
+				printf("FlatQuadtree: failed to delete %d\n", j);
+				return 1;
+			}
+		}
+		int expectedSize = numPoints - (numPoints + 2) / 3;
+
+		int countedSize = 0;
+		for(auto it = points.begin(); it != points.end(); ++it) {
+			countedSize++;
+		}
+
+		if(points.size() != (unsigned int)expectedSize || countedSize != expectedSize) {
+			printf("FlatQuadtree: reported size %d, counted size %d, expected size %d\n",
+					points.size(), countedSize, expectedSize);
+			return 1;
+		}
+
+		AABB area(getRandomPoint(), Vector2(rand() % 50, rand() % 50));
+		auto res = points.query(area);
+		auto refres = ref.query(area);
+		std::sort(res.begin(), res.end());
+		std::sort(refres.begin(), refres.end());
+		if(res != refres) {
+			printf("FlatQuadtree: query returned %zu points, expected %zu\n",
+					res.size(), refres.size());
+			return 1;
+		}
+	}
+
+	printf("Successfully passed 1000 tests.\n");
+	return 0;
+}
+
+template<typename Tree>
+static int testUpdate(const char* name)
+{
+	for(int i = 0; i < 100; i++) {
+		Tree points(AABB(Vector2(0, 0), Vector2(500, 500)));
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			points.insert(j, positions[j]);
+		}
+
+		for(int k = 0; k < 10; k++) {
+			for(int j = 0; j < numPoints; j++) {
+				Vector2 newpos = positions[j] + Vector2(rand() % 11 - 5, rand() % 11 - 5);
+				newpos.x = clamp(-500.0f, newpos.x, 500.0f);
+				newpos.y = clamp(-500.0f, newpos.y, 500.0f);
+				if(!points.update(j, positions[j], newpos)) {
+					printf("%s: failed to update %d\n", name, j);
+					return 1;
+				}
+				positions[j] = newpos;
+			}
+
+			AABB area(getRandomPoint(), Vector2(rand() % 50, rand() % 50));
+			auto res = points.query(area);
+			std::vector<int> expected;
+			for(int j = 0; j < numPoints; j++) {
+				if(area.contains(positions[j]))
+					expected.push_back(j);
+			}
+			std::sort(res.begin(), res.end());
+			if(res != expected || points.size() != (unsigned int)numPoints) {
+				printf("%s: query returned %zu points, expected %zu\n",
+						name, res.size(), expected.size());
+				return 1;
+			}
+		}
+
+		for(int j = 0; j < numPoints; j++) {
+			if(!points.deleteT(j, positions[j])) {
+				printf("%s: failed to delete %d after updates\n", name, j);
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 100 tests.\n");
+	return 0;
+}
+
+int quadtree_update(int argc, char** argv)
+{
+	return testUpdate<QuadTree<int>>("Quadtree") ||
+		testUpdate<FlatQuadTree<int>>("FlatQuadtree");
+}
+
+template<typename Tree, typename Item, typename Pos, typename Contains>
+static int testBulkLoad(const char* name, Pos getPos, Contains contains)
+{
+	for(int i = 0; i < 20; i++) {
+		AABB boundary(Vector2(0, 0), Vector2(500, 500));
+		Tree inserted(boundary);
+		std::vector<std::pair<int, Item>> items;
+		int numPoints = 10 + rand() % 20000;
+		for(int j = 0; j < numPoints; j++) {
+			items.push_back(std::make_pair(j, getPos()));
+			inserted.insert(j, items[j].second);
+		}
+
+		Tree serial(boundary, items);
+		Tree parallel(boundary, items, 4);
+
+		for(int k = 0; k < 100; k++) {
+			AABB area(getRandomPoint(), Vector2(rand() % 50, rand() % 50));
+			std::vector<int> expected;
+			for(auto& it : items) {
+				if(contains(area, it.second))
+					expected.push_back(it.first);
+			}
+
+			for(Tree* t : { &inserted, &serial, &parallel }) {
+				auto res = t->query(area);
+				std::sort(res.begin(), res.end());
+				if(res != expected) {
+					printf("%s: bulk loaded query returned %zu items, expected %zu\n",
+							name, res.size(), expected.size());
+					return 1;
+				}
+			}
+		}
+
+		if(serial.size() != inserted.size() || parallel.size() != inserted.size()) {
+			printf("%s: bulk loaded sizes %d and %d, expected %d\n",
+					name, serial.size(), parallel.size(), inserted.size());
+			return 1;
+		}
+
+		for(auto& it : items) {
+			if(!parallel.deleteT(it.first, it.second)) {
+				printf("%s: failed to delete %d from bulk loaded tree\n", name, it.first);
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
+
+static bool pointInArea(const AABB& area, const Vector2& p)
+{
+	return area.contains(p);
+}
+
+static bool lineInArea(const AABB& area, const AABB& l)
+{
+	return area.intersects(l);
+}
+
+int quadtree_bulkload(int argc, char** argv)
+{
+	return testBulkLoad<QuadTree<int>, Vector2>("Quadtree", getRandomPoint, pointInArea) ||
+		testBulkLoad<FlatQuadTree<int>, Vector2>("FlatQuadtree", getRandomPoint, pointInArea) ||
+		testBulkLoad<LineQuadTree<int>, AABB>("LineQuadtree", getRandomLine, lineInArea);
+}
+
+template<typename Tree>
+static int testNearest(const char* name)
+{
+	for(int i = 0; i < 100; i++) {
+		Tree points(AABB(Vector2(0, 0), Vector2(500, 500)));
+		int numPoints = 10 + rand() % 10 * 100;
+		std::vector<Vector2> positions;
+		for(int j = 0; j < numPoints; j++) {
+			positions.push_back(getRandomPoint());
+			points.insert(j, positions[j]);
+		}
+
+		for(int k = 0; k < 20; k++) {
+			if(!checkNearest(name, points, positions, getRandomPoint(), 1 + rand() % 10, rand() % 20))
+				return 1;
+		}
+	}
+
+	printf("Successfully passed 100 tests.\n");
+	return 0;
+}
+
+int quadtree_nearest(int argc, char** argv)
+{
+	return testNearest<QuadTree<int>>("Quadtree") ||
+		testNearest<FlatQuadTree<int>>("FlatQuadtree");
+}
+
+int linequadtree_loose(int argc, char** argv)
+{
+	for(int i = 0; i < 20; i++) {
+		AABB boundary(Vector2(0, 0), Vector2(500, 500));
+		LineQuadTree<int> inserted(boundary, 2.0f);
+		std::vector<std::pair<int, AABB>> items;
+		int numLines = 10 + rand() % 20000;
+		for(int j = 0; j < numLines; j++) {
+			items.push_back(std::make_pair(j, getRandomLine()));
+			bool ret = inserted.insert(j, items[j].second);
+			assert(ret);
+		}
+
+		LineQuadTree<int> serial(boundary, items, 1, 2.0f);
+		LineQuadTree<int> parallel(boundary, items, 4, 2.0f);
+
+		// move some lines around
+		for(int j = 0; j < numLines / 10; j++) {
+			int k = rand() % numLines;
+			AABB newpos = getRandomLine();
+			inserted.update(k, items[k].second, newpos);
+			serial.update(k, items[k].second, newpos);
+			parallel.update(k, items[k].second, newpos);
+			items[k].second = newpos;
+		}
+
+		for(int k = 0; k < 100; k++) {
+			AABB area(getRandomPoint(), Vector2(rand() % 50, rand() % 50));
+			std::vector<int> expected;
+			for(auto& it : items) {
+				if(area.intersects(it.second))
+					expected.push_back(it.first);
+			}
+
+			for(LineQuadTree<int>* t : { &inserted, &serial, &parallel }) {
+				auto res = t->query(area);
+				std::sort(res.begin(), res.end());
+				if(res != expected) {
+					printf("Loose LineQuadtree: query returned %zu items, expected %zu\n",
+							res.size(), expected.size());
+					return 1;
+				}
+			}
+		}
+
+		for(auto& it : items) {
+			if(!inserted.deleteT(it.first, it.second) ||
+					!parallel.deleteT(it.first, it.second)) {
+				printf("Loose LineQuadtree: failed to delete %d\n", it.first);
+				return 1;
+			}
+		}
+
+		if(inserted.size() != 0 || parallel.size() != 0) {
+			printf("Loose LineQuadtree: %d and %d lines left after deleting all\n",
+					inserted.size(), parallel.size());
+			return 1;
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
@@ -126,7 +126,7 @@ Vector3 Steering::obstacleAvoidance(const std::vector<Obstacle*> obstacles)
 	return res;
 }
 
-Vector3 Steering::cohesion(const std::vector<Entity*> neighbours)
+Vector3 Steering::cohesion(const std::vector<Entity*>& neighbours)
 {
 	Vector3 centerOfMass;
 
@@ -148,7 +148,7 @@ Vector3 Steering::cohesion(const std::vector<Entity*> neighbours)
 	}
 }
 
-Vector3 Steering::separation(const std::vector<Entity*> neighbours)
+Vector3 Steering::separation(const std::vector<Entity*>& neighbours)
 {
 	Vector3 res;
 
@@ -166,6 +166,28 @@ Vector3 Steering::separation(const std::vector<Entity*> neighbours)
 	return res;
 }
 
+Vector3 Steering::alignment(const std::vector<Entity*>& neighbours)
+{
+	Vector3 averageVelocity;
+
+	int count = 0;
+	for(auto n : neighbours) {
+		if(n == &mUnit)
+			continue;
+
+		averageVelocity += n->getVelocity();
+		count++;
+	}
+
+	if(count) {
+		averageVelocity *= (1.0f / count);
+		return averageVelocity - mUnit.getVelocity();
+	}
+	else {
+		return Vector3();
+	}
+}
+
 Vector3 Steering::offsetPursuit(const Vehicle& leader, const Vector3& offset)
 {
 	Vector3 rotatedOffset = Math::rotate2D(offset, leader.getXYRotation());
@@ -179,6 +201,20 @@ Vector3 Steering::offsetPursuit(const Vehicle& leader, const Vector3& offset)
 	return arrive(rotatedOffset + leader.getVelocity() * lookAheadTime);
 }
 
+Vector3 Steering::followFlowField(const FlowField& field)
+{
+	Point2 cell;
+	if(!field.cellAt(mUnit.getPosition(), cell) || field.getDistance(cell.x, cell.y) < 0)
+		return Vector3();
+
+	if(cell.x == field.getGoal().x && cell.y == field.getGoal().y)
+		return arrive(field.getGoalPosition());
+
+	Vector3 desiredVelocity = field.getDirection(cell.x, cell.y) * mUnit.getMaxSpeed();
+
+	return desiredVelocity - mUnit.getVelocity();
+}
+
 bool Steering::accumulate(Vector3& runningTotal, const Vector3& add)
 {
 	float magnitude = runningTotal.length();
@@ -205,24 +241,35 @@ Vector3 Steering::wallAvoidance(const std::vector<Wall*> walls)
 	float distToNearest = FLT_MAX;
 
 	for(auto w : walls) {
-		bool found = false;
-		Math::segmentSegmentIntersection2D(mUnit.getPosition(),
-				mUnit.getPosition() + mUnit.getVelocity() * 0.5f,
-				w->getStart(), w->getEnd(), &found);
+		checkWall(w, distToNearest, nearestPointOnWall);
+	}
 
-		Vector3 nearest;
+	if(distToNearest == FLT_MAX) {
+		return Vector3();
+	}
 
-		float dist = Math::pointToSegmentDistance(w->getStart(),
-				w->getEnd(),
-				mUnit.getPosition(), &nearest);
+	Vector3 vecFromPoint = mUnit.getPosition() - nearestPointOnWall;
+	Vector3 res = vecFromPoint.normalized() * 10.0f;
 
-		if(found || dist < mUnit.getMaxSpeed() * 0.5f) {
-			if(dist < distToNearest) {
-				distToNearest = dist;
-				nearestPointOnWall = nearest;
-			}
-		}
-	}
+	return res;
+}
+
+Vector3 Steering::wallAvoidance(const WallBVH& walls)
+{
+	Vector3 nearestPointOnWall;
+	float distToNearest = FLT_MAX;
+
+	// only the walls near the feeler or within the distance limit can matter,
+	// though walls at exactly the same distance may be picked in another order
+	const Vector3& pos = mUnit.getPosition();
+	Vector3 feeler = pos + mUnit.getVelocity() * 0.5f;
+	float range = mUnit.getMaxSpeed() * 0.5f;
+	Vector2 mn(std::min(pos.x - range, feeler.x), std::min(pos.y - range, feeler.y));
+	Vector2 mx(std::max(pos.x + range, feeler.x), std::max(pos.y + range, feeler.y));
+
+	walls.query(AABB((mn + mx) * 0.5f, (mx - mn) * 0.5f), [&] (const Wall* w) {
+			checkWall(w, distToNearest, nearestPointOnWall);
+			});
 
 	if(distToNearest == FLT_MAX) {
 		return Vector3();
@@ -234,5 +281,26 @@ Vector3 Steering::wallAvoidance(const std::vector<Wall*> walls)
 	return res;
 }
 
+void Steering::checkWall(const Wall* w, float& distToNearest, Vector3& nearestPointOnWall) const
+{
+	bool found = false;
+	Math::segmentSegmentIntersection2D(mUnit.getPosition(),
+			mUnit.getPosition() + mUnit.getVelocity() * 0.5f,
+			w->getStart(), w->getEnd(), &found);
+
+	Vector3 nearest;
+
+	float dist = Math::pointToSegmentDistance(w->getStart(),
+			w->getEnd(),
+			mUnit.getPosition(), &nearest);
+
+	if(found || dist < mUnit.getMaxSpeed() * 0.5f) {
+		if(dist < distToNearest) {
+			distToNearest = dist;
+			nearestPointOnWall = nearest;
+		}
+	}
+}
+
 }
 
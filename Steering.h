@@ -1,8 +1,12 @@
 #ifndef COMMON_STEERING_H
 #define COMMON_STEERING_H
 
+#include <vector>
+
+#include "FlowField.h"
 #include "Vector3.h"
 #include "Vehicle.h"
+#include "WallBVH.h"
 
 namespace Common {
 
@@ -17,12 +21,16 @@ class Steering {
 		Vector3 wander(float radius = 2.0f, float distance = 1.0f, float jitter = 3.0f);
 		Vector3 obstacleAvoidance(const std::vector<Obstacle*> obstacles);
 		Vector3 wallAvoidance(const std::vector<Wall*> walls);
-		Vector3 cohesion(const std::vector<Entity*> neighbours);
-		Vector3 separation(const std::vector<Entity*> neighbours);
+		Vector3 wallAvoidance(const WallBVH& walls);
+		Vector3 cohesion(const std::vector<Entity*>& neighbours);
+		Vector3 separation(const std::vector<Entity*>& neighbours);
+		Vector3 alignment(const std::vector<Entity*>& neighbours);
 		Vector3 offsetPursuit(const Vehicle& leader, const Vector3& offset);
+		Vector3 followFlowField(const FlowField& field);
 		bool accumulate(Vector3& runningTotal, const Vector3& add);
 
 	private:
+		void checkWall(const Wall* w, float& distToNearest, Vector3& nearestPointOnWall) const;
 		const Vehicle& mUnit;
 		Vector3 mWanderTarget;
 };
@@ -0,0 +1,204 @@
+#include "SteeringBatch.h"
+
+#include <cassert>
+#include <cmath>
+
+#include <algorithm>
+
+namespace Common {
+
+// The kernels take restrict pointers, as otherwise the compiler would
+// have to check every pair of arrays for overlap before vectorising.
+// Divisions by zero lengths are avoided with std::max rather than
+// branches; the direction is zero then anyway.
+static const float MIN_LENGTH = 1e-20f;
+
+// towards the targets, or away from them with sign -1
+static void seekKernel(unsigned int n, float sign,
+		const float* __restrict tx, const float* __restrict ty, const float* __restrict tz,
+		const float* __restrict px, const float* __restrict py, const float* __restrict pz,
+		const float* __restrict vx, const float* __restrict vy, const float* __restrict vz,
+		const float* __restrict ms,
+		float* __restrict ox, float* __restrict oy, float* __restrict oz)
+{
+	for(unsigned int i = 0; i < n; i++) {
+		float dx = (tx[i] - px[i]) * sign;
+		float dy = (ty[i] - py[i]) * sign;
+		float dz = (tz[i] - pz[i]) * sign;
+		float len = sqrtf(dx * dx + dy * dy + dz * dz);
+		float scale = ms[i] / std::max(len, MIN_LENGTH);
+		ox[i] = dx * scale - vx[i];
+		oy[i] = dy * scale - vy[i];
+		oz[i] = dz * scale - vz[i];
+	}
+}
+
+static void arriveKernel(unsigned int n,
+		const float* __restrict tx, const float* __restrict ty, const float* __restrict tz,
+		const float* __restrict px, const float* __restrict py, const float* __restrict pz,
+		const float* __restrict vx, const float* __restrict vy, const float* __restrict vz,
+		const float* __restrict ms,
+		float* __restrict ox, float* __restrict oy, float* __restrict oz)
+{
+	for(unsigned int i = 0; i < n; i++) {
+		float dx = tx[i] - px[i];
+		float dy = ty[i] - py[i];
+		float dz = tz[i] - pz[i];
+		float len = sqrtf(dx * dx + dy * dy + dz * dz);
+		// no force at all once there
+		float keep = len < 0.0001f ? 0.0f : 1.0f;
+		float scale = keep * std::min(len / 0.6f, ms[i]) / std::max(len, MIN_LENGTH);
+		ox[i] = dx * scale - vx[i] * keep;
+		oy[i] = dy * scale - vy[i] * keep;
+		oz[i] = dz * scale - vz[i] * keep;
+	}
+}
+
+SteeringBatch::SteeringBatch(unsigned int n)
+{
+	resize(n);
+}
+
+void SteeringBatch::resize(unsigned int n)
+{
+	position.resize(n);
+	velocity.resize(n);
+	maxSpeed.resize(n);
+	maxAcceleration.resize(n);
+}
+
+unsigned int SteeringBatch::size() const
+{
+	return maxSpeed.size();
+}
+
+void SteeringBatch::setVehicle(unsigned int i, const Vehicle& v)
+{
+	position.set(i, v.getPosition());
+	velocity.set(i, v.getVelocity());
+	maxSpeed[i] = v.getMaxSpeed();
+	maxAcceleration[i] = v.getMaxAcceleration();
+}
+
+void SteeringBatch::seek(const Vector3Array& targets, Vector3Array& out) const
+{
+	assert(targets.size() == size());
+	out.resize(size());
+	seekKernel(size(), 1.0f, targets.x.data(), targets.y.data(), targets.z.data(),
+			position.x.data(), position.y.data(), position.z.data(),
+			velocity.x.data(), velocity.y.data(), velocity.z.data(), maxSpeed.data(),
+			out.x.data(), out.y.data(), out.z.data());
+}
+
+void SteeringBatch::flee(const Vector3Array& threats, Vector3Array& out) const
+{
+	assert(threats.size() == size());
+	out.resize(size());
+	seekKernel(size(), -1.0f, threats.x.data(), threats.y.data(), threats.z.data(),
+			position.x.data(), position.y.data(), position.z.data(),
+			velocity.x.data(), velocity.y.data(), velocity.z.data(), maxSpeed.data(),
+			out.x.data(), out.y.data(), out.z.data());
+}
+
+void SteeringBatch::arrive(const Vector3Array& targets, Vector3Array& out) const
+{
+	assert(targets.size() == size());
+	out.resize(size());
+	arriveKernel(size(), targets.x.data(), targets.y.data(), targets.z.data(),
+			position.x.data(), position.y.data(), position.z.data(),
+			velocity.x.data(), velocity.y.data(), velocity.z.data(), maxSpeed.data(),
+			out.x.data(), out.y.data(), out.z.data());
+}
+
+void SteeringBatch::pursuit(const std::vector<unsigned int>& targets, Vector3Array& out) const
+{
+	assert(targets.size() == size());
+	unsigned int n = size();
+	Vector3Array aims;
+	aims.resize(n);
+	for(unsigned int i = 0; i < n; i++) {
+		unsigned int t = targets[i];
+		float dx = position.x[t] - position.x[i];
+		float dy = position.y[t] - position.y[i];
+		float dz = position.z[t] - position.z[i];
+		float relHeading = velocity.x[i] * velocity.x[t] + velocity.y[i] * velocity.y[t] +
+			velocity.z[i] * velocity.z[t];
+		float lookAheadTime = 0.0f;
+		if(!(dx * position.x[i] + dy * position.y[i] + dz * position.z[i] > 0.0f && relHeading < -0.95f)) {
+			float speed = sqrtf(velocity.x[t] * velocity.x[t] + velocity.y[t] * velocity.y[t] +
+					velocity.z[t] * velocity.z[t]);
+			lookAheadTime = sqrtf(dx * dx + dy * dy + dz * dz) * (1.0f / (maxSpeed[i] + speed));
+		}
+		aims.x[i] = position.x[t] + velocity.x[t] * lookAheadTime;
+		aims.y[i] = position.y[t] + velocity.y[t] * lookAheadTime;
+		aims.z[i] = position.z[t] + velocity.z[t] * lookAheadTime;
+	}
+	seek(aims, out);
+}
+
+void SteeringBatch::cohesion(const std::vector<unsigned int>& first, const std::vector<unsigned int>& neighbours,
+		Vector3Array& out) const
+{
+	assert(first.size() == size() + 1);
+	unsigned int n = size();
+	Vector3Array centers;
+	centers.resize(n);
+	std::vector<float> counts(n);
+	for(unsigned int i = 0; i < n; i++) {
+		float cx = 0.0f, cy = 0.0f, cz = 0.0f;
+		int count = 0;
+		for(unsigned int j = first[i]; j < first[i + 1]; j++) {
+			unsigned int k = neighbours[j];
+			if(k == i)
+				continue;
+			cx += position.x[k];
+			cy += position.y[k];
+			cz += position.z[k];
+			count++;
+		}
+		float scale = count ? 1.0f / count : 0.0f;
+		centers.x[i] = cx * scale;
+		centers.y[i] = cy * scale;
+		centers.z[i] = cz * scale;
+		counts[i] = count;
+	}
+
+	seek(centers, out);
+	for(unsigned int i = 0; i < n; i++) {
+		float keep = counts[i] ? 1.0f : 0.0f;
+		out.x[i] *= keep;
+		out.y[i] *= keep;
+		out.z[i] *= keep;
+	}
+}
+
+void SteeringBatch::separation(const std::vector<unsigned int>& first, const std::vector<unsigned int>& neighbours,
+		Vector3Array& out) const
+{
+	assert(first.size() == size() + 1);
+	unsigned int n = size();
+	out.resize(n);
+	const float* px = position.x.data();
+	const float* py = position.y.data();
+	const float* pz = position.z.data();
+	for(unsigned int i = 0; i < n; i++) {
+		float rx = 0.0f, ry = 0.0f, rz = 0.0f;
+		for(unsigned int j = first[i]; j < first[i + 1]; j++) {
+			unsigned int k = neighbours[j];
+			float dx = px[i] - px[k];
+			float dy = py[i] - py[k];
+			float dz = pz[i] - pz[k];
+			// away from each neighbour, the harder the nearer it is -
+			// including this vehicle and others at the same spot adds nothing
+			float scale = 1.0f / std::max(dx * dx + dy * dy + dz * dz, MIN_LENGTH);
+			rx += dx * scale;
+			ry += dy * scale;
+			rz += dz * scale;
+		}
+		out.x[i] = rx;
+		out.y[i] = ry;
+		out.z[i] = rz;
+	}
+}
+
+}
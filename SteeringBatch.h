@@ -0,0 +1,78 @@
+#ifndef COMMON_STEERINGBATCH_H
+#define COMMON_STEERINGBATCH_H
+
+#include <vector>
+
+#include "Vector3.h"
+#include "Vehicle.h"
+
+namespace Common {
+
+// Vector3s as three arrays of floats.
+struct Vector3Array {
+	std::vector<float> x;
+	std::vector<float> y;
+	std::vector<float> z;
+	inline void resize(unsigned int n);
+	inline unsigned int size() const;
+	inline Vector3 get(unsigned int i) const;
+	inline void set(unsigned int i, const Vector3& v);
+};
+
+// The state of a population of vehicles as a structure of arrays, and the
+// Steering behaviours computed for all of them at once in loops the
+// compiler can vectorise. The results match those of Steering for each
+// vehicle within float precision. Neighbours are given as index lists:
+// those of vehicle i are neighbours[first[i]] to neighbours[first[i + 1] - 1].
+class SteeringBatch {
+	public:
+		SteeringBatch(unsigned int n = 0);
+		void resize(unsigned int n);
+		unsigned int size() const;
+		void setVehicle(unsigned int i, const Vehicle& v);
+
+		// each writes one force per vehicle to out, which mustn't be one of
+		// the inputs
+		void seek(const Vector3Array& targets, Vector3Array& out) const;
+		void flee(const Vector3Array& threats, Vector3Array& out) const;
+		void arrive(const Vector3Array& targets, Vector3Array& out) const;
+		// targets are the indices of the vehicles pursued
+		void pursuit(const std::vector<unsigned int>& targets, Vector3Array& out) const;
+		void cohesion(const std::vector<unsigned int>& first, const std::vector<unsigned int>& neighbours,
+				Vector3Array& out) const;
+		void separation(const std::vector<unsigned int>& first, const std::vector<unsigned int>& neighbours,
+				Vector3Array& out) const;
+
+		Vector3Array position;
+		Vector3Array velocity;
+		std::vector<float> maxSpeed;
+		std::vector<float> maxAcceleration;
+};
+
+void Vector3Array::resize(unsigned int n)
+{
+	x.resize(n);
+	y.resize(n);
+	z.resize(n);
+}
+
+unsigned int Vector3Array::size() const
+{
+	return x.size();
+}
+
+Vector3 Vector3Array::get(unsigned int i) const
+{
+	return Vector3(x[i], y[i], z[i]);
+}
+
+void Vector3Array::set(unsigned int i, const Vector3& v)
+{
+	x[i] = v.x;
+	y[i] = v.y;
+	z[i] = v.z;
+}
+
+}
+
+#endif
@@ -0,0 +1,237 @@
+#include <stdlib.h>
+
+#include "Clock.h"
+#include "Flock.h"
+#include "Steering.h"
+#include "SteeringBatch.h"
+#include "VehicleWorld.h"
+#include "WallBVH.h"
+
+using namespace Common;
+
+static const int NUM_WALLS = 5000;
+static const int NUM_VEHICLES = 2000;
+
+static Vector3 getRandomPoint()
+{
+	// not on integer coordinates so that no two walls are equally near
+	return Vector3(rand() % 100000 / 100.0f - 500, rand() % 100000 / 100.0f - 500, 0);
+}
+
+int steering_wallavoidance(int argc, char** argv)
+{
+	std::vector<Wall*> walls;
+	for(int i = 0; i < NUM_WALLS; i++) {
+		Vector3 start = getRandomPoint();
+		walls.push_back(new Wall(start, start + Vector3(rand() % 40 - 20, rand() % 40 - 20, 0)));
+	}
+
+	std::vector<Vehicle> vehicles;
+	for(int i = 0; i < NUM_VEHICLES; i++) {
+		vehicles.push_back(Vehicle(1.0f, 20.0f, 10.0f));
+		vehicles.back().setPosition(getRandomPoint());
+		vehicles.back().setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+	}
+
+	double t0 = Clock::getTime();
+	WallBVH bvh(walls);
+
+	double t1 = Clock::getTime();
+	Vector3 total1;
+	for(auto& v : vehicles) {
+		total1 += Steering(v).wallAvoidance(walls);
+	}
+
+	double t2 = Clock::getTime();
+	Vector3 total2;
+	for(auto& v : vehicles) {
+		total2 += Steering(v).wallAvoidance(bvh);
+	}
+
+	double t3 = Clock::getTime();
+
+	printf("Wall avoidance, %d vehicles, %d walls: build %.3f s, brute force %.3f s, BVH %.3f s\n",
+			NUM_VEHICLES, NUM_WALLS, t1 - t0, t2 - t1, t3 - t2);
+
+	for(auto w : walls)
+		delete w;
+
+	if(total1.x != total2.x || total1.y != total2.y) {
+		printf("Wall avoidance: results differ\n");
+		return 1;
+	}
+	return 0;
+}
+
+int steering_batch(int argc, char** argv)
+{
+	const unsigned int NUM_BATCH_VEHICLES = 20000;
+	const int NUM_NEIGHBOURS = 8;
+	const int NUM_FRAMES = 20;
+
+	// vehicles as separate heap objects, as a game would have them
+	std::vector<Vehicle*> vehicles;
+	Vector3Array targets;
+	targets.resize(NUM_BATCH_VEHICLES);
+	SteeringBatch batch(NUM_BATCH_VEHICLES);
+	for(unsigned int i = 0; i < NUM_BATCH_VEHICLES; i++) {
+		vehicles.push_back(new Vehicle(1.0f, 20.0f, 10.0f));
+		vehicles.back()->setPosition(getRandomPoint());
+		vehicles.back()->setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+		batch.setVehicle(i, *vehicles.back());
+		targets.set(i, getRandomPoint());
+	}
+
+	std::vector<unsigned int> first;
+	std::vector<unsigned int> neighbours;
+	std::vector<std::vector<Entity*>> lists(NUM_BATCH_VEHICLES);
+	for(unsigned int i = 0; i < NUM_BATCH_VEHICLES; i++) {
+		first.push_back(neighbours.size());
+		for(int j = 0; j < NUM_NEIGHBOURS; j++) {
+			unsigned int k = rand() % NUM_BATCH_VEHICLES;
+			neighbours.push_back(k);
+			lists[i].push_back(vehicles[k]);
+		}
+	}
+	first.push_back(neighbours.size());
+
+	double t0 = Clock::getTime();
+	Vector3 total1;
+	for(int f = 0; f < NUM_FRAMES; f++) {
+		for(unsigned int i = 0; i < NUM_BATCH_VEHICLES; i++) {
+			Steering s(*vehicles[i]);
+			total1 += s.seek(targets.get(i));
+			total1 += s.arrive(targets.get(i));
+			total1 += s.separation(lists[i]);
+			total1 += s.cohesion(lists[i]);
+		}
+	}
+
+	double t1 = Clock::getTime();
+	Vector3 total2;
+	Vector3Array out[4];
+	for(int f = 0; f < NUM_FRAMES; f++) {
+		batch.seek(targets, out[0]);
+		batch.arrive(targets, out[1]);
+		batch.separation(first, neighbours, out[2]);
+		batch.cohesion(first, neighbours, out[3]);
+		for(int j = 0; j < 4; j++) {
+			for(unsigned int i = 0; i < NUM_BATCH_VEHICLES; i++)
+				total2 += out[j].get(i);
+		}
+	}
+
+	double t2 = Clock::getTime();
+
+	printf("Steering, %d vehicles, %d frames: scalar %.3f s (%.1f ns per vehicle), batch %.3f s (%.1f ns per vehicle)\n",
+			NUM_BATCH_VEHICLES, NUM_FRAMES,
+			t1 - t0, (t1 - t0) * 1e9 / (NUM_BATCH_VEHICLES * NUM_FRAMES),
+			t2 - t1, (t2 - t1) * 1e9 / (NUM_BATCH_VEHICLES * NUM_FRAMES));
+
+	for(auto v : vehicles)
+		delete v;
+
+	if((total1 - total2).length() > 0.001f * (1.0f + total1.length())) {
+		printf("Batch steering: results differ\n");
+		return 1;
+	}
+	return 0;
+}
+
+int steering_flock(int argc, char** argv)
+{
+	const unsigned int NUM_BOIDS = 10000;
+	const float RADIUS = 15.0f;
+	const int NUM_FRAMES = 20;
+
+	std::vector<Vehicle*> vehicles;
+	for(unsigned int i = 0; i < NUM_BOIDS; i++) {
+		vehicles.push_back(new Vehicle(1.0f, 20.0f, 10.0f));
+		vehicles.back()->setPosition(getRandomPoint());
+		vehicles.back()->setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+	}
+
+	// gathering the neighbours by hand, once
+	double t0 = Clock::getTime();
+	Vector3 total1;
+	std::vector<Entity*> neighbours;
+	for(unsigned int i = 0; i < NUM_BOIDS; i++) {
+		neighbours.clear();
+		for(unsigned int j = 0; j < NUM_BOIDS; j++) {
+			if((vehicles[j]->getPosition() - vehicles[i]->getPosition()).length2() <= RADIUS * RADIUS)
+				neighbours.push_back(vehicles[j]);
+		}
+		Steering s(*vehicles[i]);
+		total1 += s.separation(neighbours);
+		total1 += s.cohesion(neighbours);
+		total1 += s.alignment(neighbours);
+	}
+
+	double t1 = Clock::getTime();
+	Flock flock(1000.0f, 1000.0f, RADIUS);
+	std::vector<Vector3> forces;
+	Vector3 total2;
+	for(int f = 0; f < NUM_FRAMES; f++) {
+		flock.update(vehicles, forces);
+		total2 = Vector3();
+		for(auto& v : forces)
+			total2 += v;
+	}
+
+	double t2 = Clock::getTime();
+
+	printf("Flocking, %d vehicles: gathered neighbours %.3f s per frame, flock %.3f s per frame (%.1f ns per vehicle)\n",
+			NUM_BOIDS, t1 - t0, (t2 - t1) / NUM_FRAMES,
+			(t2 - t1) * 1e9 / (NUM_BOIDS * NUM_FRAMES));
+
+	for(auto v : vehicles)
+		delete v;
+
+	if((total1 - total2).length() > 0.001f * (1.0f + total1.length())) {
+		printf("Flock: results differ\n");
+		return 1;
+	}
+	return 0;
+}
+
+int steering_world(int argc, char** argv)
+{
+	const unsigned int NUM_WORLD_VEHICLES = 20000;
+	const int NUM_FRAMES = 20;
+
+	double times[2];
+	Vector3 totals[2];
+	unsigned int threads[] = { 0, 3 };
+	for(int j = 0; j < 2; j++) {
+		srand(1);
+		std::vector<Vehicle> vehicles;
+		VehicleWorld world(threads[j]);
+		for(unsigned int i = 0; i < NUM_WORLD_VEHICLES; i++) {
+			vehicles.push_back(Vehicle(1.0f, 20.0f, 10.0f));
+			vehicles.back().setPosition(getRandomPoint());
+			vehicles.back().setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+		}
+		for(auto& v : vehicles)
+			world.add(&v);
+		world.setBehaviour([&] (unsigned int i, Steering& s, Vector3& total) {
+				s.accumulate(total, s.pursuit(vehicles[(i + 1) % NUM_WORLD_VEHICLES]));
+				s.accumulate(total, s.arrive(Vector3()));
+				});
+
+		double t0 = Clock::getTime();
+		for(int f = 0; f < NUM_FRAMES; f++)
+			world.update(0.02f);
+		times[j] = Clock::getTime() - t0;
+		for(auto& v : vehicles)
+			totals[j] += v.getPosition();
+	}
+
+	printf("Vehicle world, %d vehicles, %d frames: 1 thread %.3f s, %d threads %.3f s\n",
+			NUM_WORLD_VEHICLES, NUM_FRAMES, times[0], threads[1] + 1, times[1]);
+
+	if(totals[0].x != totals[1].x || totals[0].y != totals[1].y) {
+		printf("Vehicle world: results differ\n");
+		return 1;
+	}
+	return 0;
+}
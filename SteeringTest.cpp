@@ -0,0 +1,207 @@
+#include <stdlib.h>
+
+#include "Steering.h"
+#include "SteeringBatch.h"
+#include "Flock.h"
+#include "VehicleWorld.h"
+
+using namespace Common;
+
+static Vector3 getRandomPoint()
+{
+	return Vector3(rand() % 2000 / 10.0f - 100, rand() % 2000 / 10.0f - 100, 0);
+}
+
+static bool close(const Vector3& a, const Vector3& b)
+{
+	return (a - b).length() <= 0.001f * (1.0f + b.length());
+}
+
+int steering_batch(int argc, char** argv)
+{
+	for(int i = 0; i < 20; i++) {
+		unsigned int n = 1 + rand() % 200;
+		std::vector<Vehicle> vehicles;
+		Vector3Array targets;
+		targets.resize(n);
+		std::vector<unsigned int> pursued;
+		SteeringBatch batch(n);
+		for(unsigned int k = 0; k < n; k++) {
+			vehicles.push_back(Vehicle(1.0f, 1.0f + rand() % 20, 10.0f));
+			vehicles.back().setPosition(getRandomPoint());
+			if(rand() % 5)
+				vehicles.back().setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+			batch.setVehicle(k, vehicles.back());
+
+			// some targets right on or next to the vehicle
+			Vector3 t = rand() % 5 ? getRandomPoint() : vehicles.back().getPosition();
+			targets.set(k, t);
+			pursued.push_back(rand() % n);
+		}
+
+		// up to ten random neighbours, possibly including the vehicle itself
+		std::vector<unsigned int> first;
+		std::vector<unsigned int> neighbours;
+		std::vector<std::vector<Entity*>> lists(n);
+		for(unsigned int k = 0; k < n; k++) {
+			first.push_back(neighbours.size());
+			for(int j = rand() % 10; j > 0; j--) {
+				unsigned int m = rand() % n;
+				neighbours.push_back(m);
+				lists[k].push_back(&vehicles[m]);
+			}
+		}
+		first.push_back(neighbours.size());
+
+		Vector3Array out[6];
+		batch.seek(targets, out[0]);
+		batch.flee(targets, out[1]);
+		batch.arrive(targets, out[2]);
+		batch.pursuit(pursued, out[3]);
+		batch.cohesion(first, neighbours, out[4]);
+		batch.separation(first, neighbours, out[5]);
+		for(unsigned int k = 0; k < n; k++) {
+			Steering s(vehicles[k]);
+			Vector3 expected[6] = {
+				s.seek(targets.get(k)),
+				s.flee(targets.get(k)),
+				s.arrive(targets.get(k)),
+				s.pursuit(vehicles[pursued[k]]),
+				s.cohesion(lists[k]),
+				s.separation(lists[k])
+			};
+			for(int j = 0; j < 6; j++) {
+				if(!close(out[j].get(k), expected[j])) {
+					printf("SteeringBatch: behaviour %d gives (%f, %f, %f), expected (%f, %f, %f)\n",
+							j, out[j].x[k], out[j].y[k], out[j].z[k],
+							expected[j].x, expected[j].y, expected[j].z);
+					return 1;
+				}
+			}
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
+
+int steering_flock(int argc, char** argv)
+{
+	const float radius = 10.05f;
+	Flock flock(200.0f, 200.0f, radius);
+	for(int i = 0; i < 20; i++) {
+		unsigned int n = 1 + rand() % 300;
+		std::vector<Vehicle> vehicles;
+		for(unsigned int k = 0; k < n; k++) {
+			vehicles.push_back(Vehicle(1.0f, 1.0f + rand() % 20, 10.0f));
+			// some on top of each other
+			vehicles.back().setPosition(k && rand() % 10 == 0 ? vehicles[k - 1].getPosition() : getRandomPoint());
+			if(rand() % 5)
+				vehicles.back().setVelocity(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+		}
+		std::vector<Vehicle*> ptrs;
+		for(auto& v : vehicles)
+			ptrs.push_back(&v);
+
+		float ws = rand() % 4, wc = rand() % 4, wa = rand() % 4;
+		flock.setWeights(ws, wc, wa);
+		std::vector<Vector3> out;
+		flock.update(ptrs, out);
+		if(out.size() != n) {
+			printf("Flock: %d forces for %d vehicles\n", int(out.size()), n);
+			return 1;
+		}
+
+		for(unsigned int k = 0; k < n; k++) {
+			std::vector<Entity*> neighbours;
+			for(unsigned int m = 0; m < n; m++) {
+				if((vehicles[m].getPosition() - vehicles[k].getPosition()).length2() <= radius * radius)
+					neighbours.push_back(&vehicles[m]);
+			}
+			Steering s(vehicles[k]);
+			Vector3 expected = s.separation(neighbours) * ws +
+				s.cohesion(neighbours) * wc +
+				s.alignment(neighbours) * wa;
+			if(!close(out[k], expected)) {
+				printf("Flock: vehicle %d gets (%f, %f, %f), expected (%f, %f, %f)\n",
+						k, out[k].x, out[k].y, out[k].z,
+						expected.x, expected.y, expected.z);
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
+
+int steering_world(int argc, char** argv)
+{
+	const unsigned int n = 500;
+	const int frames = 20;
+	std::vector<Vector3> positions;
+	std::vector<Vector3> velocities;
+	for(unsigned int k = 0; k < n; k++) {
+		positions.push_back(getRandomPoint());
+		velocities.push_back(Vector3(rand() % 40 - 20, rand() % 40 - 20, 0));
+	}
+
+	// reference: forces from the state at the start of each frame, all
+	// on one thread without the world
+	std::vector<Vehicle> expected;
+	for(unsigned int k = 0; k < n; k++) {
+		expected.push_back(Vehicle(1.0f, 5.0f + k % 20, 10.0f));
+		expected.back().setPosition(positions[k]);
+		expected.back().setVelocity(velocities[k]);
+	}
+	auto behave = [&] (const std::vector<Vehicle>& vehicles, unsigned int k, Steering& s, Vector3& total) {
+		const Vehicle& v = vehicles[(k + 1) % n];
+		s.accumulate(total, s.pursuit(v) * 0.5f);
+		s.accumulate(total, s.flee(vehicles[(k + 7) % n].getPosition()));
+		s.accumulate(total, s.arrive(Vector3()));
+	};
+	for(int f = 0; f < frames; f++) {
+		std::vector<Vector3> forces(n);
+		for(unsigned int k = 0; k < n; k++) {
+			Steering s(expected[k]);
+			behave(expected, k, s, forces[k]);
+		}
+		for(unsigned int k = 0; k < n; k++) {
+			expected[k].setAcceleration(forces[k]);
+			expected[k].update(0.05f);
+		}
+	}
+
+	unsigned int threads[] = { 0, 1, 3, 7 };
+	for(auto t : threads) {
+		std::vector<Vehicle> vehicles;
+		VehicleWorld world(t);
+		for(unsigned int k = 0; k < n; k++) {
+			vehicles.push_back(Vehicle(1.0f, 5.0f + k % 20, 10.0f));
+			vehicles.back().setPosition(positions[k]);
+			vehicles.back().setVelocity(velocities[k]);
+		}
+		for(auto& v : vehicles)
+			world.add(&v);
+		world.setBehaviour([&] (unsigned int k, Steering& s, Vector3& total) {
+				behave(vehicles, k, s, total);
+				});
+		for(int f = 0; f < frames; f++)
+			world.update(0.05f);
+
+		for(unsigned int k = 0; k < n; k++) {
+			const Vector3& p = vehicles[k].getPosition();
+			const Vector3& e = expected[k].getPosition();
+			if(p.x != e.x || p.y != e.y || p.z != e.z ||
+					vehicles[k].getVelocity().x != expected[k].getVelocity().x ||
+					vehicles[k].getVelocity().y != expected[k].getVelocity().y) {
+				printf("VehicleWorld: %d threads: vehicle %d at (%f, %f), expected (%f, %f)\n",
+						t, k, p.x, p.y, e.x, e.y);
+				return 1;
+			}
+		}
+	}
+
+	printf("Successfully passed 4 tests.\n");
+	return 0;
+}
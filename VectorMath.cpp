@@ -0,0 +1,199 @@
+#include "VectorMath.h"
+
+#include <atomic>
+
+#include "VectorMathKernels.h"
+
+namespace Common {
+
+static_assert(sizeof(Vector2) == 2 * sizeof(float), "Vector2 must be two floats");
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be three floats");
+
+namespace {
+
+struct Dispatch {
+	VectorMathKernels kernels[3];
+	bool supported[3];
+	std::atomic<int> current;
+
+	Dispatch()
+	{
+		getKernels<Scalar>(kernels[int(VectorMath::ISA::Scalar)]);
+		supported[int(VectorMath::ISA::Scalar)] = true;
+		supported[int(VectorMath::ISA::SSE)] = getSSEKernels(kernels[int(VectorMath::ISA::SSE)]);
+		supported[int(VectorMath::ISA::AVX)] = hasAVX() && getAVXKernels(kernels[int(VectorMath::ISA::AVX)]);
+		int best = 0;
+		for(int i = 0; i < 3; i++) {
+			if(supported[i])
+				best = i;
+		}
+		current = best;
+	}
+
+	static bool hasAVX()
+	{
+#if defined(COMMON_VECTORMATH_X86) && defined(__GNUC__)
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx");
+#else
+		return false;
+#endif
+	}
+};
+
+}
+
+static Dispatch& getDispatch()
+{
+	static Dispatch d;
+	return d;
+}
+
+static const VectorMathKernelSet& kernels2()
+{
+	Dispatch& d = getDispatch();
+	return d.kernels[d.current.load(std::memory_order_relaxed)].vector2;
+}
+
+static const VectorMathKernelSet& kernels3()
+{
+	Dispatch& d = getDispatch();
+	return d.kernels[d.current.load(std::memory_order_relaxed)].vector3;
+}
+
+static const float* floats(const Vector2* v)
+{
+	return reinterpret_cast<const float*>(v);
+}
+
+static const float* floats(const Vector3* v)
+{
+	return reinterpret_cast<const float*>(v);
+}
+
+static float* floats(Vector2* v)
+{
+	return reinterpret_cast<float*>(v);
+}
+
+static float* floats(Vector3* v)
+{
+	return reinterpret_cast<float*>(v);
+}
+
+VectorMath::ISA VectorMath::getISA()
+{
+	return ISA(getDispatch().current.load());
+}
+
+bool VectorMath::setISA(ISA isa)
+{
+	Dispatch& d = getDispatch();
+	if(!d.supported[int(isa)])
+		return false;
+	d.current = int(isa);
+	return true;
+}
+
+const char* VectorMath::getISAName(ISA isa)
+{
+	switch(isa) {
+		case ISA::Scalar: return "scalar";
+		case ISA::SSE: return "SSE";
+		case ISA::AVX: return "AVX";
+	}
+	return "";
+}
+
+void VectorMath::add(const Vector2* a, const Vector2* b, Vector2* out, unsigned int n)
+{
+	kernels2().add(floats(a), floats(b), floats(out), n);
+}
+
+void VectorMath::add(const Vector3* a, const Vector3* b, Vector3* out, unsigned int n)
+{
+	kernels3().add(floats(a), floats(b), floats(out), n);
+}
+
+void VectorMath::addScaled(const Vector2* a, const Vector2* b, float s, Vector2* out, unsigned int n)
+{
+	kernels2().addScaled(floats(a), floats(b), s, floats(out), n);
+}
+
+void VectorMath::addScaled(const Vector3* a, const Vector3* b, float s, Vector3* out, unsigned int n)
+{
+	kernels3().addScaled(floats(a), floats(b), s, floats(out), n);
+}
+
+void VectorMath::scale(const Vector2* a, float s, Vector2* out, unsigned int n)
+{
+	kernels2().scale(floats(a), s, floats(out), n);
+}
+
+void VectorMath::scale(const Vector3* a, float s, Vector3* out, unsigned int n)
+{
+	kernels3().scale(floats(a), s, floats(out), n);
+}
+
+void VectorMath::dot(const Vector2* a, const Vector2* b, float* out, unsigned int n)
+{
+	kernels2().dot(floats(a), floats(b), out, n);
+}
+
+void VectorMath::dot(const Vector3* a, const Vector3* b, float* out, unsigned int n)
+{
+	kernels3().dot(floats(a), floats(b), out, n);
+}
+
+void VectorMath::length(const Vector2* a, float* out, unsigned int n)
+{
+	kernels2().length(floats(a), out, n);
+}
+
+void VectorMath::length(const Vector3* a, float* out, unsigned int n)
+{
+	kernels3().length(floats(a), out, n);
+}
+
+void VectorMath::normalize(const Vector2* a, Vector2* out, unsigned int n)
+{
+	kernels2().normalize(floats(a), floats(out), n);
+}
+
+void VectorMath::normalize(const Vector3* a, Vector3* out, unsigned int n)
+{
+	kernels3().normalize(floats(a), floats(out), n);
+}
+
+void VectorMath::truncate(const Vector2* a, float len, Vector2* out, unsigned int n)
+{
+	kernels2().truncate(floats(a), len, floats(out), n);
+}
+
+void VectorMath::truncate(const Vector3* a, float len, Vector3* out, unsigned int n)
+{
+	kernels3().truncate(floats(a), len, floats(out), n);
+}
+
+void VectorMath::distance2(const Vector2* a, const Vector2* b, float* out, unsigned int n)
+{
+	kernels2().distance2(floats(a), floats(b), out, n);
+}
+
+void VectorMath::distance2(const Vector3* a, const Vector3* b, float* out, unsigned int n)
+{
+	kernels3().distance2(floats(a), floats(b), out, n);
+}
+
+void VectorMath::rotate2D(const Vector2* a, float angle, Vector2* out, unsigned int n)
+{
+	// as in Math::rotate2D()
+	kernels2().rotate2D(floats(a), cos(angle), sin(angle), floats(out), n);
+}
+
+void VectorMath::rotate2D(const Vector3* a, float angle, Vector3* out, unsigned int n)
+{
+	kernels3().rotate2D(floats(a), cos(angle), sin(angle), floats(out), n);
+}
+
+}
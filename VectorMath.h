@@ -0,0 +1,50 @@
+#ifndef COMMON_VECTORMATH_H
+#define COMMON_VECTORMATH_H
+
+#include "Vector2.h"
+#include "Vector3.h"
+
+namespace Common {
+
+// Vector2 and Vector3 operations over whole arrays, with SSE and AVX
+// kernels chosen at run time by what the CPU supports. The results are
+// the same as those of the Vector2/Vector3 and Math functions of the same
+// names, bit for bit, whichever kernels are used. The output may be one
+// of the input arrays, but mustn't overlap them otherwise.
+class VectorMath {
+	public:
+		enum class ISA {
+			Scalar,
+			SSE,
+			AVX
+		};
+		static ISA getISA();
+		// for comparing the kernels - false if the CPU doesn't support isa
+		static bool setISA(ISA isa);
+		static const char* getISAName(ISA isa);
+
+		static void add(const Vector2* a, const Vector2* b, Vector2* out, unsigned int n);
+		static void add(const Vector3* a, const Vector3* b, Vector3* out, unsigned int n);
+		// a + b * s
+		static void addScaled(const Vector2* a, const Vector2* b, float s, Vector2* out, unsigned int n);
+		static void addScaled(const Vector3* a, const Vector3* b, float s, Vector3* out, unsigned int n);
+		static void scale(const Vector2* a, float s, Vector2* out, unsigned int n);
+		static void scale(const Vector3* a, float s, Vector3* out, unsigned int n);
+		// in float, unlike Vector2::dot and Vector3::dot
+		static void dot(const Vector2* a, const Vector2* b, float* out, unsigned int n);
+		static void dot(const Vector3* a, const Vector3* b, float* out, unsigned int n);
+		static void length(const Vector2* a, float* out, unsigned int n);
+		static void length(const Vector3* a, float* out, unsigned int n);
+		static void normalize(const Vector2* a, Vector2* out, unsigned int n);
+		static void normalize(const Vector3* a, Vector3* out, unsigned int n);
+		static void truncate(const Vector2* a, float len, Vector2* out, unsigned int n);
+		static void truncate(const Vector3* a, float len, Vector3* out, unsigned int n);
+		static void distance2(const Vector2* a, const Vector2* b, float* out, unsigned int n);
+		static void distance2(const Vector3* a, const Vector3* b, float* out, unsigned int n);
+		static void rotate2D(const Vector2* a, float angle, Vector2* out, unsigned int n);
+		static void rotate2D(const Vector3* a, float angle, Vector3* out, unsigned int n);
+};
+
+}
+
+#endif
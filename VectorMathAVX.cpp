@@ -0,0 +1,89 @@
+// The system headers come first so that only the kernels are compiled
+// for AVX; VectorMath only calls them once the CPU is known to have it.
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#if defined(__SSE2__) && defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__SSE2__)
+#pragma GCC push_options
+#pragma GCC target("avx")
+#endif
+
+#include "VectorMathKernels.h"
+
+namespace Common {
+
+#ifdef COMMON_VECTORMATH_X86
+namespace {
+
+// eight vectors as two halves of four
+struct AVX {
+	typedef __m256 V;
+	typedef __m256 M;
+	static const unsigned int WIDTH = 8;
+	static V load(const float* p) { return _mm256_loadu_ps(p); }
+	static void store(float* p, V v) { _mm256_storeu_ps(p, v); }
+	static V set1(float f) { return _mm256_set1_ps(f); }
+	static V add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm256_div_ps(a, b); }
+	static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+	// the same comparisons as those of SSE and Scalar, including NaNs
+	static M greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+	static M notEqual(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+	// not blendv, which GCC may split into a branch per lane
+	static V select(M m, V a, V b) { return _mm256_or_ps(_mm256_and_ps(m, a), _mm256_andnot_ps(m, b)); }
+
+	static V combine(__m128 lo, __m128 hi)
+	{
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(lo), hi, 1);
+	}
+
+	template<int N>
+	static void deinterleave(const float* p, V (&c)[N])
+	{
+		SSE::V lo[N], hi[N];
+		SSE::deinterleave(p, lo);
+		SSE::deinterleave(p + 4 * N, hi);
+		for(int k = 0; k < N; k++)
+			c[k] = combine(lo[k], hi[k]);
+	}
+
+	template<int N>
+	static void interleave(float* p, const V (&c)[N])
+	{
+		SSE::V lo[N], hi[N];
+		for(int k = 0; k < N; k++) {
+			lo[k] = _mm256_castps256_ps128(c[k]);
+			hi[k] = _mm256_extractf128_ps(c[k], 1);
+		}
+		SSE::interleave(p, lo);
+		SSE::interleave(p + 4 * N, hi);
+	}
+};
+
+}
+#endif
+
+bool getAVXKernels(VectorMathKernels& k)
+{
+#ifdef COMMON_VECTORMATH_X86
+	getKernels<AVX>(k);
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
+
+#if defined(__SSE2__) && defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__SSE2__)
+#pragma GCC pop_options
+#endif
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+
+#include <vector>
+
+#include "Clock.h"
+#include "VectorMath.h"
+
+using namespace Common;
+
+static const unsigned int NUM_VECTORS = 100000;
+static const int NUM_ROUNDS = 100;
+
+int vectormath_kernels(int argc, char** argv)
+{
+	std::vector<Vector3> a, b;
+	for(unsigned int i = 0; i < NUM_VECTORS; i++) {
+		a.push_back(Vector3(rand() % 1000 - 500, rand() % 1000 - 500, rand() % 1000 - 500));
+		b.push_back(Vector3(rand() % 1000 - 500, rand() % 1000 - 500, rand() % 1000 - 500));
+	}
+	std::vector<Vector3> v(NUM_VECTORS);
+	std::vector<float> f(NUM_VECTORS);
+
+	double t0 = Clock::getTime();
+	float total1 = 0.0f;
+	for(int r = 0; r < NUM_ROUNDS; r++) {
+		// the same passes as with the kernels below
+		for(unsigned int i = 0; i < NUM_VECTORS; i++) {
+			v[i] = a[i];
+			v[i].truncate(300.0f);
+		}
+		for(unsigned int i = 0; i < NUM_VECTORS; i++)
+			total1 += v[i].x;
+		for(unsigned int i = 0; i < NUM_VECTORS; i++)
+			f[i] = a[i].distance2(b[i]);
+		for(unsigned int i = 0; i < NUM_VECTORS; i++)
+			total1 += f[i];
+		for(unsigned int i = 0; i < NUM_VECTORS; i++)
+			v[i] = a[i].normalized();
+		for(unsigned int i = 0; i < NUM_VECTORS; i++)
+			total1 += v[i].y;
+	}
+	double t1 = Clock::getTime();
+	printf("Vector math, %d vectors, %d rounds: loop %.3f s", NUM_VECTORS, NUM_ROUNDS, t1 - t0);
+
+	VectorMath::ISA best = VectorMath::getISA();
+	VectorMath::ISA isas[] = { VectorMath::ISA::Scalar, VectorMath::ISA::SSE, VectorMath::ISA::AVX };
+	bool ok = true;
+	for(auto isa : isas) {
+		if(!VectorMath::setISA(isa))
+			continue;
+		t0 = Clock::getTime();
+		float total2 = 0.0f;
+		for(int r = 0; r < NUM_ROUNDS; r++) {
+			VectorMath::truncate(a.data(), 300.0f, v.data(), NUM_VECTORS);
+			for(unsigned int i = 0; i < NUM_VECTORS; i++)
+				total2 += v[i].x;
+			VectorMath::distance2(a.data(), b.data(), f.data(), NUM_VECTORS);
+			for(unsigned int i = 0; i < NUM_VECTORS; i++)
+				total2 += f[i];
+			VectorMath::normalize(a.data(), v.data(), NUM_VECTORS);
+			for(unsigned int i = 0; i < NUM_VECTORS; i++)
+				total2 += v[i].y;
+		}
+		t1 = Clock::getTime();
+		printf(", %s %.3f s", VectorMath::getISAName(isa), t1 - t0);
+		// the kernels give the same results as the loops
+		if(total1 != total2)
+			ok = false;
+	}
+	printf("\n");
+	VectorMath::setISA(best);
+
+	if(!ok) {
+		printf("Vector math: results differ\n");
+		return 1;
+	}
+	return 0;
+}
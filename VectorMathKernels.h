@@ -0,0 +1,333 @@
+#ifndef COMMON_VECTORMATHKERNELS_H
+#define COMMON_VECTORMATHKERNELS_H
+
+// Internal to VectorMath: the kernels as templates over the instruction
+// set, instantiated in one translation unit per instruction set.
+
+#include <math.h>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#define COMMON_VECTORMATH_X86
+#endif
+
+namespace Common {
+
+// the kernels for vectors of one size, on arrays of floats
+struct VectorMathKernelSet {
+	void (*add)(const float* a, const float* b, float* out, unsigned int n);
+	void (*addScaled)(const float* a, const float* b, float s, float* out, unsigned int n);
+	void (*scale)(const float* a, float s, float* out, unsigned int n);
+	void (*dot)(const float* a, const float* b, float* out, unsigned int n);
+	void (*length)(const float* a, float* out, unsigned int n);
+	void (*normalize)(const float* a, float* out, unsigned int n);
+	void (*truncate)(const float* a, float len, float* out, unsigned int n);
+	void (*distance2)(const float* a, const float* b, float* out, unsigned int n);
+	void (*rotate2D)(const float* a, float c, float s, float* out, unsigned int n);
+};
+
+struct VectorMathKernels {
+	VectorMathKernelSet vector2;
+	VectorMathKernelSet vector3;
+};
+
+// false if not built for this architecture
+bool getSSEKernels(VectorMathKernels& k);
+bool getAVXKernels(VectorMathKernels& k);
+
+// Everything below has internal linkage: each translation unit compiles
+// it for its own instruction set, and the linker mustn't pick the AVX
+// copy of a function for the others. For the same reason the kernels use
+// no inline functions with external linkage, such as those of Vector3.
+namespace {
+
+// the instruction set traits: V holds WIDTH floats, M a mask of as many
+struct Scalar {
+	typedef float V;
+	typedef bool M;
+	static const unsigned int WIDTH = 1;
+	static V load(const float* p) { return *p; }
+	static void store(float* p, V v) { *p = v; }
+	static V set1(float f) { return f; }
+	static V add(V a, V b) { return a + b; }
+	static V sub(V a, V b) { return a - b; }
+	static V mul(V a, V b) { return a * b; }
+	static V div(V a, V b) { return a / b; }
+	static V sqrt(V a) { return sqrtf(a); }
+	static M greater(V a, V b) { return a > b; }
+	static M notEqual(V a, V b) { return a != b; }
+	static V select(M m, V a, V b) { return m ? a : b; }
+	static void deinterleave(const float* p, V (&c)[2]) { c[0] = p[0]; c[1] = p[1]; }
+	static void deinterleave(const float* p, V (&c)[3]) { c[0] = p[0]; c[1] = p[1]; c[2] = p[2]; }
+	static void interleave(float* p, const V (&c)[2]) { p[0] = c[0]; p[1] = c[1]; }
+	static void interleave(float* p, const V (&c)[3]) { p[0] = c[0]; p[1] = c[1]; p[2] = c[2]; }
+};
+
+#ifdef COMMON_VECTORMATH_X86
+// lane i of the result takes the a'th lane for i = 0 and so on
+#define COMMON_SHUFFLE(a, b, c, d) _MM_SHUFFLE(d, c, b, a)
+
+struct SSE {
+	typedef __m128 V;
+	typedef __m128 M;
+	static const unsigned int WIDTH = 4;
+	static V load(const float* p) { return _mm_loadu_ps(p); }
+	static void store(float* p, V v) { _mm_storeu_ps(p, v); }
+	static V set1(float f) { return _mm_set1_ps(f); }
+	static V add(V a, V b) { return _mm_add_ps(a, b); }
+	static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V div(V a, V b) { return _mm_div_ps(a, b); }
+	static V sqrt(V a) { return _mm_sqrt_ps(a); }
+	static M greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+	static M notEqual(V a, V b) { return _mm_cmpneq_ps(a, b); }
+	static V select(M m, V a, V b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+	// x0 y0 x1 y1 x2 y2 x3 y3
+	static void deinterleave(const float* p, V (&c)[2])
+	{
+		V a = _mm_loadu_ps(p);
+		V b = _mm_loadu_ps(p + 4);
+		c[0] = _mm_shuffle_ps(a, b, COMMON_SHUFFLE(0, 2, 0, 2));
+		c[1] = _mm_shuffle_ps(a, b, COMMON_SHUFFLE(1, 3, 1, 3));
+	}
+
+	static void interleave(float* p, const V (&c)[2])
+	{
+		_mm_storeu_ps(p, _mm_unpacklo_ps(c[0], c[1]));
+		_mm_storeu_ps(p + 4, _mm_unpackhi_ps(c[0], c[1]));
+	}
+
+	// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+	static void deinterleave(const float* p, V (&c)[3])
+	{
+		V a = _mm_loadu_ps(p);
+		V b = _mm_loadu_ps(p + 4);
+		V d = _mm_loadu_ps(p + 8);
+		c[0] = _mm_shuffle_ps(a, _mm_shuffle_ps(b, d, COMMON_SHUFFLE(2, 0, 1, 0)),
+				COMMON_SHUFFLE(0, 3, 0, 2));
+		c[1] = _mm_shuffle_ps(_mm_shuffle_ps(a, b, COMMON_SHUFFLE(1, 0, 0, 0)),
+				_mm_shuffle_ps(b, d, COMMON_SHUFFLE(3, 0, 2, 0)),
+				COMMON_SHUFFLE(0, 2, 0, 2));
+		c[2] = _mm_shuffle_ps(_mm_shuffle_ps(a, b, COMMON_SHUFFLE(2, 0, 1, 0)),
+				_mm_shuffle_ps(d, d, COMMON_SHUFFLE(0, 3, 0, 0)),
+				COMMON_SHUFFLE(0, 2, 0, 1));
+	}
+
+	static void interleave(float* p, const V (&c)[3])
+	{
+		const V& x = c[0];
+		const V& y = c[1];
+		const V& z = c[2];
+		_mm_storeu_ps(p, _mm_shuffle_ps(_mm_shuffle_ps(x, y, COMMON_SHUFFLE(0, 0, 0, 0)),
+					_mm_shuffle_ps(z, x, COMMON_SHUFFLE(0, 0, 1, 1)),
+					COMMON_SHUFFLE(0, 2, 0, 2)));
+		_mm_storeu_ps(p + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, COMMON_SHUFFLE(1, 1, 1, 1)),
+					_mm_shuffle_ps(x, y, COMMON_SHUFFLE(2, 2, 2, 2)),
+					COMMON_SHUFFLE(0, 2, 0, 2)));
+		_mm_storeu_ps(p + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, COMMON_SHUFFLE(2, 2, 3, 3)),
+					_mm_shuffle_ps(y, z, COMMON_SHUFFLE(3, 3, 3, 3)),
+					COMMON_SHUFFLE(0, 2, 0, 2)));
+	}
+};
+#endif
+
+// the operations on the vectors from begin to end, a multiple of
+// S::WIDTH apart; N is the number of components
+template<class S, int N>
+struct Ops {
+	typedef typename S::V V;
+
+	static V length2(const V (&c)[N])
+	{
+		V r = S::mul(c[0], c[0]);
+		for(int k = 1; k < N; k++)
+			r = S::add(r, S::mul(c[k], c[k]));
+		return r;
+	}
+
+	static void dot(const float* a, const float* b, float* out, unsigned int begin, unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N], d[N];
+			S::deinterleave(a + i * N, c);
+			S::deinterleave(b + i * N, d);
+			V r = S::mul(c[0], d[0]);
+			for(int k = 1; k < N; k++)
+				r = S::add(r, S::mul(c[k], d[k]));
+			S::store(out + i, r);
+		}
+	}
+
+	static void length(const float* a, float* out, unsigned int begin, unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N];
+			S::deinterleave(a + i * N, c);
+			S::store(out + i, S::sqrt(length2(c)));
+		}
+	}
+
+	static void normalize(const float* a, float* out, unsigned int begin, unsigned int end)
+	{
+		V zero = S::set1(0.0f);
+		V one = S::set1(1.0f);
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N];
+			S::deinterleave(a + i * N, c);
+			V l = S::sqrt(length2(c));
+			// zero vectors stay as they are
+			l = S::select(S::notEqual(l, zero), l, one);
+			for(int k = 0; k < N; k++)
+				c[k] = S::div(c[k], l);
+			S::interleave(out + i * N, c);
+		}
+	}
+
+	static void truncate(const float* a, float len, float* out, unsigned int begin, unsigned int end)
+	{
+		V maxlen = S::set1(len);
+		V maxlen2 = S::set1(len * len);
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N];
+			S::deinterleave(a + i * N, c);
+			V l2 = length2(c);
+			typename S::M over = S::greater(l2, maxlen2);
+			V l = S::sqrt(l2);
+			for(int k = 0; k < N; k++)
+				c[k] = S::select(over, S::mul(S::div(c[k], l), maxlen), c[k]);
+			S::interleave(out + i * N, c);
+		}
+	}
+
+	static void distance2(const float* a, const float* b, float* out, unsigned int begin, unsigned int end)
+	{
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N], d[N];
+			S::deinterleave(a + i * N, c);
+			S::deinterleave(b + i * N, d);
+			for(int k = 0; k < N; k++)
+				c[k] = S::sub(c[k], d[k]);
+			S::store(out + i, length2(c));
+		}
+	}
+
+	static void rotate2D(const float* a, float cs, float sn, float* out, unsigned int begin, unsigned int end)
+	{
+		V vc = S::set1(cs);
+		V vs = S::set1(sn);
+		for(unsigned int i = begin; i < end; i += S::WIDTH) {
+			V c[N];
+			S::deinterleave(a + i * N, c);
+			V x = S::sub(S::mul(c[0], vc), S::mul(c[1], vs));
+			V y = S::add(S::mul(c[0], vs), S::mul(c[1], vc));
+			c[0] = x;
+			c[1] = y;
+			S::interleave(out + i * N, c);
+		}
+	}
+};
+
+// whole arrays: full blocks with S, the rest with Scalar
+template<class S, int N>
+struct Kernels {
+	static unsigned int blocks(unsigned int n)
+	{
+		return n - n % S::WIDTH;
+	}
+
+	// the component-wise ones work on the floats directly
+	static void add(const float* a, const float* b, float* out, unsigned int n)
+	{
+		unsigned int count = n * N;
+		unsigned int m = count - count % S::WIDTH;
+		for(unsigned int i = 0; i < m; i += S::WIDTH)
+			S::store(out + i, S::add(S::load(a + i), S::load(b + i)));
+		for(unsigned int i = m; i < count; i++)
+			out[i] = a[i] + b[i];
+	}
+
+	static void addScaled(const float* a, const float* b, float s, float* out, unsigned int n)
+	{
+		unsigned int count = n * N;
+		unsigned int m = count - count % S::WIDTH;
+		typename S::V vs = S::set1(s);
+		for(unsigned int i = 0; i < m; i += S::WIDTH)
+			S::store(out + i, S::add(S::load(a + i), S::mul(S::load(b + i), vs)));
+		for(unsigned int i = m; i < count; i++)
+			out[i] = a[i] + b[i] * s;
+	}
+
+	static void scale(const float* a, float s, float* out, unsigned int n)
+	{
+		unsigned int count = n * N;
+		unsigned int m = count - count % S::WIDTH;
+		typename S::V vs = S::set1(s);
+		for(unsigned int i = 0; i < m; i += S::WIDTH)
+			S::store(out + i, S::mul(S::load(a + i), vs));
+		for(unsigned int i = m; i < count; i++)
+			out[i] = a[i] * s;
+	}
+
+	static void dot(const float* a, const float* b, float* out, unsigned int n)
+	{
+		Ops<S, N>::dot(a, b, out, 0, blocks(n));
+		Ops<Scalar, N>::dot(a, b, out, blocks(n), n);
+	}
+
+	static void length(const float* a, float* out, unsigned int n)
+	{
+		Ops<S, N>::length(a, out, 0, blocks(n));
+		Ops<Scalar, N>::length(a, out, blocks(n), n);
+	}
+
+	static void normalize(const float* a, float* out, unsigned int n)
+	{
+		Ops<S, N>::normalize(a, out, 0, blocks(n));
+		Ops<Scalar, N>::normalize(a, out, blocks(n), n);
+	}
+
+	static void truncate(const float* a, float len, float* out, unsigned int n)
+	{
+		Ops<S, N>::truncate(a, len, out, 0, blocks(n));
+		Ops<Scalar, N>::truncate(a, len, out, blocks(n), n);
+	}
+
+	static void distance2(const float* a, const float* b, float* out, unsigned int n)
+	{
+		Ops<S, N>::distance2(a, b, out, 0, blocks(n));
+		Ops<Scalar, N>::distance2(a, b, out, blocks(n), n);
+	}
+
+	static void rotate2D(const float* a, float c, float s, float* out, unsigned int n)
+	{
+		Ops<S, N>::rotate2D(a, c, s, out, 0, blocks(n));
+		Ops<Scalar, N>::rotate2D(a, c, s, out, blocks(n), n);
+	}
+
+	static void get(VectorMathKernelSet& k)
+	{
+		k.add = add;
+		k.addScaled = addScaled;
+		k.scale = scale;
+		k.dot = dot;
+		k.length = length;
+		k.normalize = normalize;
+		k.truncate = truncate;
+		k.distance2 = distance2;
+		k.rotate2D = rotate2D;
+	}
+};
+
+template<class S>
+void getKernels(VectorMathKernels& k)
+{
+	Kernels<S, 2>::get(k.vector2);
+	Kernels<S, 3>::get(k.vector3);
+}
+
+}
+
+}
+
+#endif
@@ -0,0 +1,15 @@
+#include "VectorMathKernels.h"
+
+namespace Common {
+
+bool getSSEKernels(VectorMathKernels& k)
+{
+#ifdef COMMON_VECTORMATH_X86
+	getKernels<SSE>(k);
+	return true;
+#else
+	return false;
+#endif
+}
+
+}
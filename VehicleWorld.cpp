@@ -0,0 +1,133 @@
+#include "VehicleWorld.h"
+
+#include <cassert>
+
+#include <algorithm>
+
+namespace Common {
+
+VehicleWorld::VehicleWorld(unsigned int threads)
+	: mPhase(Phase::Steer),
+	mTime(0.0f),
+	mGeneration(0),
+	mRemaining(0),
+	mQuit(false)
+{
+	// the calling thread takes the first range
+	for(unsigned int i = 0; i < threads; i++)
+		mWorkers.push_back(std::thread(&VehicleWorld::work, this, i + 1));
+}
+
+VehicleWorld::~VehicleWorld()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mQuit = true;
+	}
+	mWork.notify_all();
+	for(auto& w : mWorkers)
+		w.join();
+}
+
+void VehicleWorld::add(Vehicle* v)
+{
+	mVehicles.push_back(v);
+}
+
+void VehicleWorld::remove(Vehicle* v)
+{
+	auto it = std::find(mVehicles.begin(), mVehicles.end(), v);
+	assert(it != mVehicles.end());
+	mVehicles.erase(it);
+}
+
+void VehicleWorld::clear()
+{
+	mVehicles.clear();
+}
+
+const std::vector<Vehicle*>& VehicleWorld::getVehicles() const
+{
+	return mVehicles;
+}
+
+void VehicleWorld::setBehaviour(const Behaviour& b)
+{
+	mBehaviour = b;
+}
+
+void VehicleWorld::update(float time)
+{
+	mForces.resize(mVehicles.size());
+	// no vehicle moves before all forces are known
+	dispatch(Phase::Steer, time);
+	dispatch(Phase::Integrate, time);
+}
+
+void VehicleWorld::dispatch(Phase phase, float time)
+{
+	if(mWorkers.empty()) {
+		run(phase, time, 0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mPhase = phase;
+		mTime = time;
+		mRemaining = mWorkers.size();
+		mGeneration++;
+	}
+	mWork.notify_all();
+	run(phase, time, 0);
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	mDone.wait(lock, [&] { return mRemaining == 0; });
+}
+
+void VehicleWorld::run(Phase phase, float time, unsigned int chunk)
+{
+	unsigned long long n = mVehicles.size();
+	unsigned int chunks = mWorkers.size() + 1;
+	unsigned int begin = n * chunk / chunks;
+	unsigned int end = n * (chunk + 1) / chunks;
+	for(unsigned int i = begin; i < end; i++) {
+		Vehicle* v = mVehicles[i];
+		if(phase == Phase::Steer) {
+			mForces[i] = Vector3();
+			if(mBehaviour) {
+				Steering s(*v);
+				mBehaviour(i, s, mForces[i]);
+			}
+		} else {
+			v->setAcceleration(mForces[i]);
+			v->update(time);
+		}
+	}
+}
+
+void VehicleWorld::work(unsigned int chunk)
+{
+	unsigned int generation = 0;
+	while(1) {
+		Phase phase;
+		float time;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWork.wait(lock, [&] { return mQuit || mGeneration != generation; });
+			if(mQuit)
+				return;
+			generation = mGeneration;
+			phase = mPhase;
+			time = mTime;
+		}
+
+		run(phase, time, chunk);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(--mRemaining == 0)
+			mDone.notify_one();
+	}
+}
+
+}
@@ -0,0 +1,67 @@
+#ifndef COMMON_VEHICLEWORLD_H
+#define COMMON_VEHICLEWORLD_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Steering.h"
+#include "Vehicle.h"
+
+namespace Common {
+
+// Steps a population of vehicles on a pool of worker threads, e.g. from
+// Driver::prerenderUpdate() with the frame time. A step first computes the
+// steering force of every vehicle from the state at the start of the step,
+// then integrates all of them with Vehicle::update(). The vehicles are split
+// into fixed contiguous ranges, one per thread, and the result for each
+// vehicle only depends on that state, so the results are bit-identical
+// for any number of threads.
+// That holds only as long as the behaviour reads nothing that changes
+// during the step; Steering::wander() for one draws from the global
+// Random and mustn't be used in it.
+class VehicleWorld {
+	public:
+		// adds the forces for vehicle i to total with Steering::accumulate(),
+		// in order of priority; called concurrently for different vehicles
+		typedef std::function<void (unsigned int i, Steering& steering, Vector3& total)> Behaviour;
+
+		// with no worker threads, update() runs on the calling thread only
+		VehicleWorld(unsigned int threads = 0);
+		~VehicleWorld();
+		void add(Vehicle* v);
+		void remove(Vehicle* v);
+		void clear();
+		const std::vector<Vehicle*>& getVehicles() const;
+		void setBehaviour(const Behaviour& b);
+		void update(float time);
+
+	private:
+		enum class Phase {
+			Steer,
+			Integrate
+		};
+		void dispatch(Phase phase, float time);
+		void run(Phase phase, float time, unsigned int chunk);
+		void work(unsigned int chunk);
+
+		std::vector<Vehicle*> mVehicles;
+		std::vector<Vector3> mForces;
+		Behaviour mBehaviour;
+		std::vector<std::thread> mWorkers;
+
+		std::mutex mMutex;
+		std::condition_variable mWork;
+		std::condition_variable mDone;
+		Phase mPhase;
+		float mTime;
+		unsigned int mGeneration;
+		unsigned int mRemaining;
+		bool mQuit;
+};
+
+}
+
+#endif
@@ -0,0 +1,335 @@
+#include "WallBVH.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "Math.h"
+
+namespace Common {
+
+struct WallBVH::Prim {
+	Vector2 min;
+	Vector2 max;
+	Vector2 centroid;
+	unsigned int index;
+};
+
+namespace {
+
+struct Bounds {
+	Bounds() : min(FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX) { }
+	void grow(const Vector2& mn, const Vector2& mx)
+	{
+		min = Vector2(std::min(min.x, mn.x), std::min(min.y, mn.y));
+		max = Vector2(std::max(max.x, mx.x), std::max(max.y, mx.y));
+	}
+	// half the perimeter stands in for the surface area in 2D
+	float area() const
+	{
+		return max.x < min.x ? 0.0f : (max.x - min.x) + (max.y - min.y);
+	}
+	AABB box() const
+	{
+		return AABB((min + max) * 0.5f, (max - min) * 0.5f);
+	}
+	Vector2 min;
+	Vector2 max;
+};
+
+float axis(const Vector2& v, int a)
+{
+	return a == 0 ? v.x : v.y;
+}
+
+// clips the parameter range [tmin, tmax] of p + d * t to the box
+bool segmentBox(const Vector2& p, const Vector2& d, const AABB& box, float tmin, float tmax)
+{
+	for(int a = 0; a < 2; a++) {
+		float o = axis(p, a);
+		float dir = axis(d, a);
+		float lo = axis(box.center, a) - axis(box.halfDimension, a);
+		float hi = axis(box.center, a) + axis(box.halfDimension, a);
+		if(dir == 0.0f) {
+			if(o < lo || o > hi)
+				return false;
+			continue;
+		}
+
+		float t1 = (lo - o) / dir;
+		float t2 = (hi - o) / dir;
+		if(t1 > t2)
+			std::swap(t1, t2);
+		tmin = std::max(tmin, t1);
+		tmax = std::min(tmax, t2);
+		if(tmin > tmax)
+			return false;
+	}
+	return true;
+}
+
+}
+
+WallBVH::WallBVH()
+{
+}
+
+WallBVH::WallBVH(const std::vector<Wall*>& walls)
+{
+	build(walls);
+}
+
+void WallBVH::build(const std::vector<Wall*>& walls)
+{
+	mNodes.clear();
+	mWalls.clear();
+	mStarts.clear();
+	mEnds.clear();
+	if(walls.empty())
+		return;
+
+	std::vector<Prim> prims(walls.size());
+	for(unsigned int i = 0; i < walls.size(); i++) {
+		Vector2 s(walls[i]->getStart().x, walls[i]->getStart().y);
+		Vector2 e(walls[i]->getEnd().x, walls[i]->getEnd().y);
+		prims[i].min = Vector2(std::min(s.x, e.x), std::min(s.y, e.y));
+		prims[i].max = Vector2(std::max(s.x, e.x), std::max(s.y, e.y));
+		prims[i].centroid = (s + e) * 0.5f;
+		prims[i].index = i;
+	}
+
+	mNodes.reserve(2 * walls.size());
+	buildNode(prims, 0, prims.size(), 0);
+
+	mWalls.reserve(walls.size());
+	mStarts.reserve(walls.size());
+	mEnds.reserve(walls.size());
+	for(auto& p : prims) {
+		Wall* w = walls[p.index];
+		mWalls.push_back(w);
+		mStarts.push_back(Vector2(w->getStart().x, w->getStart().y));
+		mEnds.push_back(Vector2(w->getEnd().x, w->getEnd().y));
+	}
+}
+
+unsigned int WallBVH::buildNode(std::vector<Prim>& prims, unsigned int begin, unsigned int end,
+		unsigned int depth)
+{
+	Bounds bounds;
+	Bounds centroids;
+	for(unsigned int i = begin; i < end; i++) {
+		bounds.grow(prims[i].min, prims[i].max);
+		centroids.grow(prims[i].centroid, prims[i].centroid);
+	}
+
+	unsigned int index = mNodes.size();
+	mNodes.push_back(Node(bounds.box()));
+	unsigned int count = end - begin;
+
+	// find the cheapest split over both axes
+	float bestCost = FLT_MAX;
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	for(int a = 0; a < 2 && count > 1; a++) {
+		float cmin = axis(centroids.min, a);
+		float extent = axis(centroids.max, a) - cmin;
+		if(extent <= 0.0f)
+			continue;
+
+		Bounds bins[NUM_BINS];
+		unsigned int counts[NUM_BINS] = { 0 };
+		float scale = NUM_BINS / extent;
+		for(unsigned int i = begin; i < end; i++) {
+			unsigned int b = std::min(NUM_BINS - 1, (unsigned int)((axis(prims[i].centroid, a) - cmin) * scale));
+			bins[b].grow(prims[i].min, prims[i].max);
+			counts[b]++;
+		}
+
+		// right to left sweep for the right side costs, then left to right
+		float rightCost[NUM_BINS];
+		Bounds right;
+		unsigned int rightCount = 0;
+		for(unsigned int b = NUM_BINS - 1; b > 0; b--) {
+			right.grow(bins[b].min, bins[b].max);
+			rightCount += counts[b];
+			rightCost[b] = right.area() * rightCount;
+		}
+
+		Bounds left;
+		unsigned int leftCount = 0;
+		for(unsigned int b = 0; b < NUM_BINS - 1; b++) {
+			left.grow(bins[b].min, bins[b].max);
+			leftCount += counts[b];
+			if(leftCount == 0 || leftCount == count)
+				continue;
+			float cost = left.area() * leftCount + rightCost[b + 1];
+			if(cost < bestCost) {
+				bestCost = cost;
+				bestAxis = a;
+				bestSplit = b + 1;
+			}
+		}
+	}
+
+	bool leaf = bestAxis == -1 || depth >= MAX_DEPTH;
+	if(!leaf && count <= MAX_LEAF_SIZE) {
+		leaf = bestCost >= bounds.area() * count;
+	}
+
+	if(leaf) {
+		mNodes[index].start = begin;
+		mNodes[index].count = count;
+		return index;
+	}
+
+	float cmin = axis(centroids.min, bestAxis);
+	float scale = NUM_BINS / (axis(centroids.max, bestAxis) - cmin);
+	auto mid = std::partition(prims.begin() + begin, prims.begin() + end,
+			[&] (const Prim& p) {
+			return std::min(NUM_BINS - 1, (unsigned int)((axis(p.centroid, bestAxis) - cmin) * scale)) < bestSplit;
+			});
+	unsigned int split = mid - prims.begin();
+	assert(split > begin && split < end);
+
+	buildNode(prims, begin, split, depth + 1);
+	unsigned int rightChild = buildNode(prims, split, end, depth + 1);
+	mNodes[index].start = rightChild;
+	return index;
+}
+
+unsigned int WallBVH::size() const
+{
+	return mWalls.size();
+}
+
+Wall* WallBVH::segmentCast(const Vector2& p1, const Vector2& p2, Vector2* hitpoint) const
+{
+	if(mNodes.empty())
+		return nullptr;
+
+	const Vector2 r = p2 - p1;
+	float bestT = 1.0f;
+	int best = -1;
+
+	unsigned int stack[MAX_DEPTH + 1];
+	unsigned int top = 0;
+	stack[top++] = 0;
+	while(top) {
+		const Node& n = mNodes[stack[--top]];
+		if(!segmentBox(p1, r, n.box, 0.0f, bestT))
+			continue;
+
+		if(!n.count) {
+			stack[top++] = n.start;
+			stack[top++] = &n - &mNodes[0] + 1;
+			continue;
+		}
+
+		for(unsigned int i = n.start; i < n.start + n.count; i++) {
+			// same test as Math::segmentSegmentIntersection2D
+			const Vector2 s = mEnds[i] - mStarts[i];
+			float denom = r.cross2d(s);
+			if(denom == 0.0f)
+				continue;
+
+			float t = (mStarts[i] - p1).cross2d(s) / denom;
+			float u = (mStarts[i] - p1).cross2d(r) / denom;
+			if(t < 0.0f || t > bestT || u < 0.0f || u > 1.0f)
+				continue;
+
+			if(best == -1 || t < bestT) {
+				bestT = t;
+				best = i;
+			}
+		}
+	}
+
+	if(best == -1)
+		return nullptr;
+
+	if(hitpoint)
+		*hitpoint = p1 + r * bestT;
+	return mWalls[best];
+}
+
+Wall* WallBVH::closest(const Vector2& p, float maxdist, Vector2* nearest, float* dist) const
+{
+	if(mNodes.empty())
+		return nullptr;
+
+	float best2 = maxdist * maxdist;
+	int best = -1;
+
+	unsigned int stack[MAX_DEPTH + 1];
+	unsigned int top = 0;
+	stack[top++] = 0;
+	while(top) {
+		const Node& n = mNodes[stack[--top]];
+		if(n.box.distance2(p) > best2)
+			continue;
+
+		if(n.count) {
+			for(unsigned int i = n.start; i < n.start + n.count; i++) {
+				float d2 = wallDistance2(i, p, nullptr);
+				if(d2 <= best2 && (best == -1 || d2 < best2)) {
+					best2 = d2;
+					best = i;
+				}
+			}
+			continue;
+		}
+
+		// visit the nearer child first
+		unsigned int l = &n - &mNodes[0] + 1;
+		unsigned int r = n.start;
+		if(mNodes[l].box.distance2(p) < mNodes[r].box.distance2(p))
+			std::swap(l, r);
+		stack[top++] = l;
+		stack[top++] = r;
+	}
+
+	if(best == -1)
+		return nullptr;
+
+	float d2 = wallDistance2(best, p, nearest);
+	if(dist)
+		*dist = sqrt(d2);
+	return mWalls[best];
+}
+
+void WallBVH::withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, Wall*>>& out) const
+{
+	out.clear();
+	if(mNodes.empty())
+		return;
+
+	float radius2 = radius * radius;
+	unsigned int stack[MAX_DEPTH + 1];
+	unsigned int top = 0;
+	stack[top++] = 0;
+	while(top) {
+		const Node& n = mNodes[stack[--top]];
+		if(n.box.distance2(p) > radius2)
+			continue;
+
+		if(n.count) {
+			for(unsigned int i = n.start; i < n.start + n.count; i++) {
+				float d2 = wallDistance2(i, p, nullptr);
+				if(d2 <= radius2)
+					out.push_back(std::make_pair(d2, mWalls[i]));
+			}
+		} else {
+			stack[top++] = n.start;
+			stack[top++] = &n - &mNodes[0] + 1;
+		}
+	}
+
+	std::sort(out.begin(), out.end(), NearestComp<Wall*>());
+}
+
+float WallBVH::wallDistance2(unsigned int i, const Vector2& p, Vector2* nearest) const
+{
+	float d = Math::pointToSegmentDistance(mStarts[i], mEnds[i], p, nearest);
+	return d * d;
+}
+
+}
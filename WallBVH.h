@@ -0,0 +1,88 @@
+#ifndef COMMON_WALLBVH_H
+#define COMMON_WALLBVH_H
+
+#include <cfloat>
+
+#include <vector>
+#include <utility>
+
+#include "Vector2.h"
+#include "Partition.h"
+#include "Vehicle.h"
+
+namespace Common {
+
+// Static bounding volume hierarchy over wall segments for when there are
+// too many walls to test them all. Built once with binned SAH splits and
+// stored as a flat node array in depth first order. Everything is done in
+// the XY plane; the walls are not owned and must outlive the BVH.
+class WallBVH {
+	public:
+		WallBVH();
+		WallBVH(const std::vector<Wall*>& walls);
+		// replaces the contents
+		void build(const std::vector<Wall*>& walls);
+		unsigned int size() const;
+		// calls visitor(Wall*) for walls whose bounding box intersects area
+		template<typename F>
+		inline void query(const AABB& area, F&& visitor) const;
+		// first wall hit by the segment from p1 to p2, nullptr if none
+		Wall* segmentCast(const Vector2& p1, const Vector2& p2, Vector2* hitpoint = nullptr) const;
+		// nearest wall to p not further than maxdist, nullptr if none
+		Wall* closest(const Vector2& p, float maxdist = FLT_MAX,
+				Vector2* nearest = nullptr, float* dist = nullptr) const;
+		// walls within radius of p as (squared distance, wall) pairs sorted by distance,
+		// out is overwritten
+		void withinRadius(const Vector2& p, float radius, std::vector<std::pair<float, Wall*>>& out) const;
+
+	private:
+		struct Node {
+			Node(const AABB& b) : box(b), start(0), count(0) { }
+			AABB box;
+			unsigned int start; // first wall for leaves, right child for inner nodes
+			unsigned int count; // zero for inner nodes, the left child is the next node
+		};
+		struct Prim;
+		unsigned int buildNode(std::vector<Prim>& prims, unsigned int begin, unsigned int end,
+				unsigned int depth);
+		float wallDistance2(unsigned int i, const Vector2& p, Vector2* nearest) const;
+		static const unsigned int NUM_BINS = 16;
+		static const unsigned int MAX_LEAF_SIZE = 8;
+		static const unsigned int MAX_DEPTH = 64;
+		std::vector<Node> mNodes;
+		std::vector<Wall*> mWalls; // in leaf order
+		std::vector<Vector2> mStarts;
+		std::vector<Vector2> mEnds;
+};
+
+template<typename F>
+void WallBVH::query(const AABB& area, F&& visitor) const
+{
+	if(mNodes.empty())
+		return;
+
+	unsigned int stack[MAX_DEPTH + 1];
+	unsigned int top = 0;
+	stack[top++] = 0;
+	while(top) {
+		const Node& n = mNodes[stack[--top]];
+		if(!n.box.intersects(area))
+			continue;
+
+		if(n.count) {
+			for(unsigned int i = n.start; i < n.start + n.count; i++) {
+				Vector2 mn(std::min(mStarts[i].x, mEnds[i].x), std::min(mStarts[i].y, mEnds[i].y));
+				Vector2 mx(std::max(mStarts[i].x, mEnds[i].x), std::max(mStarts[i].y, mEnds[i].y));
+				if(area.intersects(AABB((mn + mx) * 0.5f, (mx - mn) * 0.5f)))
+					visitor(mWalls[i]);
+			}
+		} else {
+			stack[top++] = n.start;
+			stack[top++] = &n - &mNodes[0] + 1;
+		}
+	}
+}
+
+}
+
+#endif
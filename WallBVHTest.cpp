@@ -0,0 +1,117 @@
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "WallBVH.h"
+#include "Steering.h"
+#include "Math.h"
+
+using namespace Common;
+
+static Vector3 getRandomPoint()
+{
+	// not on integer coordinates so that no two walls are equally near
+	return Vector3(rand() % 100000 / 100.0f - 500, rand() % 100000 / 100.0f - 500, 0);
+}
+
+static Wall* getRandomWall()
+{
+	Vector3 start = getRandomPoint();
+	Vector3 dir(rand() % 100 - 50, rand() % 100 - 50, 0);
+	return new Wall(start, start + dir);
+}
+
+static Vector2 xy(const Vector3& v)
+{
+	return Vector2(v.x, v.y);
+}
+
+int wallbvh(int argc, char** argv)
+{
+	for(int i = 0; i < 20; i++) {
+		std::vector<Wall*> walls;
+		int numWalls = 1 + rand() % 5000;
+		for(int j = 0; j < numWalls; j++) {
+			walls.push_back(getRandomWall());
+		}
+
+		WallBVH bvh(walls);
+		if(bvh.size() != walls.size()) {
+			printf("WallBVH: size %d, expected %zu\n", bvh.size(), walls.size());
+			return 1;
+		}
+
+		std::vector<std::pair<float, Wall*>> res;
+		for(int k = 0; k < 100; k++) {
+			Vector2 p1 = xy(getRandomPoint());
+			Vector2 p2 = p1 + Vector2(rand() % 200 - 100, rand() % 200 - 100);
+			float radius = rand() % 50;
+
+			float castT = FLT_MAX;
+			float closestDist = FLT_MAX;
+			std::vector<Wall*> inRadius;
+			for(auto w : walls) {
+				bool found = false;
+				Vector2 hit = Math::segmentSegmentIntersection2D(p1, p2,
+						xy(w->getStart()), xy(w->getEnd()), &found);
+				if(found)
+					castT = std::min(castT, p1.distance(hit));
+
+				float d = Math::pointToSegmentDistance(xy(w->getStart()), xy(w->getEnd()), p1);
+				closestDist = std::min(closestDist, d);
+				if(d * d <= radius * radius)
+					inRadius.push_back(w);
+			}
+
+			Vector2 hit;
+			Wall* w = bvh.segmentCast(p1, p2, &hit);
+			if((w == nullptr) != (castT == FLT_MAX) ||
+					(w && fabs(p1.distance(hit) - castT) > 0.01f)) {
+				printf("WallBVH: segment cast returned the wrong wall\n");
+				return 1;
+			}
+
+			float dist;
+			w = bvh.closest(p1, FLT_MAX, nullptr, &dist);
+			if(!w || fabs(dist - closestDist) > 0.01f) {
+				printf("WallBVH: closest wall at %f, expected %f\n", dist, closestDist);
+				return 1;
+			}
+
+			bvh.withinRadius(p1, radius, res);
+			std::vector<Wall*> found;
+			for(unsigned int j = 0; j < res.size(); j++) {
+				found.push_back(res[j].second);
+				if(j > 0 && res[j].first < res[j - 1].first) {
+					printf("WallBVH: withinRadius results not sorted\n");
+					return 1;
+				}
+			}
+			std::sort(found.begin(), found.end());
+			std::sort(inRadius.begin(), inRadius.end());
+			if(found != inRadius) {
+				printf("WallBVH: withinRadius returned %zu walls, expected %zu\n",
+						found.size(), inRadius.size());
+				return 1;
+			}
+
+			// the BVH overload must steer exactly like the brute force one
+			Vehicle v(1.0f, 20.0f + rand() % 40, 10.0f);
+			v.setPosition(getRandomPoint());
+			v.setVelocity(Vector3(rand() % 80 - 40, rand() % 80 - 40, 0));
+			Steering s(v);
+			Vector3 expected = s.wallAvoidance(walls);
+			Vector3 got = s.wallAvoidance(bvh);
+			if(expected.x != got.x || expected.y != got.y || expected.z != got.z) {
+				printf("WallBVH: wall avoidance differs from brute force\n");
+				return 1;
+			}
+		}
+
+		for(auto w : walls)
+			delete w;
+	}
+
+	printf("Successfully passed 20 tests.\n");
+	return 0;
+}
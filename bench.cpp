@@ -0,0 +1,99 @@
+#include <time.h>
+
+#include <iostream>
+#include <cstdlib>
+
+int quadtree_query(int argc, char** argv);
+int cellspacepartition_rebuild(int argc, char** argv);
+int steering_wallavoidance(int argc, char** argv);
+int steering_batch(int argc, char** argv);
+int steering_flock(int argc, char** argv);
+int steering_world(int argc, char** argv);
+int entitystore_update(int argc, char** argv);
+int vectormath_kernels(int argc, char** argv);
+int astar_grid(int argc, char** argv);
+int astar_hpa(int argc, char** argv);
+int astar_flowfield(int argc, char** argv);
+int astar_dstarlite(int argc, char** argv);
+int astar_pathcache(int argc, char** argv);
+
+int main(int argc, char** argv)
+{
+	int seed;
+	if(argc > 1)
+		seed = atoi(argv[1]);
+	else
+		seed = time(0);
+
+	std::cout << "Seed: " << seed << "\n";
+	srand(seed);
+
+	bool failed = false;
+
+	if(quadtree_query(argc, argv)) {
+		std::cerr << "Quadtree query benchmark failed.\n";
+		failed = true;
+	}
+
+	if(cellspacepartition_rebuild(argc, argv)) {
+		std::cerr << "Cell space partition rebuild benchmark failed.\n";
+		failed = true;
+	}
+
+	if(steering_wallavoidance(argc, argv)) {
+		std::cerr << "Wall avoidance benchmark failed.\n";
+		failed = true;
+	}
+
+	if(astar_grid(argc, argv)) {
+		std::cerr << "Grid A* benchmark failed.\n";
+		failed = true;
+	}
+
+	if(astar_hpa(argc, argv)) {
+		std::cerr << "Hierarchical pathfinding benchmark failed.\n";
+		failed = true;
+	}
+
+	if(astar_flowfield(argc, argv)) {
+		std::cerr << "Flow field benchmark failed.\n";
+		failed = true;
+	}
+
+	if(astar_dstarlite(argc, argv)) {
+		std::cerr << "D* Lite benchmark failed.\n";
+		failed = true;
+	}
+
+	if(astar_pathcache(argc, argv)) {
+		std::cerr << "Path cache benchmark failed.\n";
+		failed = true;
+	}
+
+	if(steering_batch(argc, argv)) {
+		std::cerr << "Batch steering benchmark failed.\n";
+		failed = true;
+	}
+
+	if(steering_flock(argc, argv)) {
+		std::cerr << "Flock benchmark failed.\n";
+		failed = true;
+	}
+
+	if(steering_world(argc, argv)) {
+		std::cerr << "Vehicle world benchmark failed.\n";
+		failed = true;
+	}
+
+	if(entitystore_update(argc, argv)) {
+		std::cerr << "Entity store benchmark failed.\n";
+		failed = true;
+	}
+
+	if(vectormath_kernels(argc, argv)) {
+		std::cerr << "Vector math benchmark failed.\n";
+		failed = true;
+	}
+
+	return failed ? 1 : 0;
+}
@@ -7,7 +7,32 @@ int math_segment_segment_3d_distance(int argc, char** argv);
 int geometry(int argc, char** argv);
 int quadtree(int argc, char** argv);
 int linequadtree(int argc, char** argv);
+int flatquadtree(int argc, char** argv);
+int quadtree_update(int argc, char** argv);
+int quadtree_bulkload(int argc, char** argv);
+int quadtree_nearest(int argc, char** argv);
+int linequadtree_loose(int argc, char** argv);
+int cellspacepartition_nearest(int argc, char** argv);
+int flatcellspacepartition(int argc, char** argv);
+int cellspacepartition_query(int argc, char** argv);
+int hierarchicalcellspacepartition(int argc, char** argv);
 int math_quaternion(int argc, char** argv);
+int wallbvh(int argc, char** argv);
+int octree(int argc, char** argv);
+int astar_grid(int argc, char** argv);
+int astar_jps(int argc, char** argv);
+int astar_hpa(int argc, char** argv);
+int astar_pathservice(int argc, char** argv);
+int astar_flowfield(int argc, char** argv);
+int astar_dstarlite(int argc, char** argv);
+int astar_search(int argc, char** argv);
+int astar_bidirectional(int argc, char** argv);
+int astar_pathcache(int argc, char** argv);
+int steering_batch(int argc, char** argv);
+int steering_flock(int argc, char** argv);
+int steering_world(int argc, char** argv);
+int entitystore_update(int argc, char** argv);
+int math_vectormath(int argc, char** argv);
 
 int main(int argc, char** argv)
 {
@@ -37,6 +62,51 @@ int main(int argc, char** argv)
 		failed = true;
 	}
 
+	if(flatquadtree(argc, argv)) {
+		std::cerr << "Flat quadtree test failed.\n";
+		failed = true;
+	}
+
+	if(quadtree_update(argc, argv)) {
+		std::cerr << "Quadtree update test failed.\n";
+		failed = true;
+	}
+
+	if(quadtree_bulkload(argc, argv)) {
+		std::cerr << "Quadtree bulk load test failed.\n";
+		failed = true;
+	}
+
+	if(quadtree_nearest(argc, argv)) {
+		std::cerr << "Quadtree nearest neighbour test failed.\n";
+		failed = true;
+	}
+
+	if(linequadtree_loose(argc, argv)) {
+		std::cerr << "Loose quadtree test failed.\n";
+		failed = true;
+	}
+
+	if(cellspacepartition_nearest(argc, argv)) {
+		std::cerr << "Cell space partition nearest neighbour test failed.\n";
+		failed = true;
+	}
+
+	if(cellspacepartition_query(argc, argv)) {
+		std::cerr << "Cell space partition query test failed.\n";
+		failed = true;
+	}
+
+	if(flatcellspacepartition(argc, argv)) {
+		std::cerr << "Flat cell space partition test failed.\n";
+		failed = true;
+	}
+
+	if(hierarchicalcellspacepartition(argc, argv)) {
+		std::cerr << "Hierarchical cell space partition test failed.\n";
+		failed = true;
+	}
+
 	if(math_segment_segment_3d_distance(argc, argv)) {
 		std::cerr << "Math segment-segment 3D distance test failed.\n";
 		failed = true;
@@ -47,5 +117,85 @@ int main(int argc, char** argv)
 		failed = true;
 	}
 
+	if(wallbvh(argc, argv)) {
+		std::cerr << "Wall BVH test failed.\n";
+		failed = true;
+	}
+
+	if(octree(argc, argv)) {
+		std::cerr << "Octree test failed.\n";
+		failed = true;
+	}
+
+	if(astar_grid(argc, argv)) {
+		std::cerr << "Grid A* test failed.\n";
+		failed = true;
+	}
+
+	if(astar_jps(argc, argv)) {
+		std::cerr << "Jump point search test failed.\n";
+		failed = true;
+	}
+
+	if(astar_hpa(argc, argv)) {
+		std::cerr << "Hierarchical pathfinding test failed.\n";
+		failed = true;
+	}
+
+	if(astar_pathservice(argc, argv)) {
+		std::cerr << "Path service test failed.\n";
+		failed = true;
+	}
+
+	if(astar_flowfield(argc, argv)) {
+		std::cerr << "Flow field test failed.\n";
+		failed = true;
+	}
+
+	if(astar_dstarlite(argc, argv)) {
+		std::cerr << "D* Lite test failed.\n";
+		failed = true;
+	}
+
+	if(astar_search(argc, argv)) {
+		std::cerr << "A* template search test failed.\n";
+		failed = true;
+	}
+
+	if(astar_bidirectional(argc, argv)) {
+		std::cerr << "Bidirectional and limited A* test failed.\n";
+		failed = true;
+	}
+
+	if(astar_pathcache(argc, argv)) {
+		std::cerr << "Path cache test failed.\n";
+		failed = true;
+	}
+
+	if(steering_batch(argc, argv)) {
+		std::cerr << "Batch steering test failed.\n";
+		failed = true;
+	}
+
+	if(steering_flock(argc, argv)) {
+		std::cerr << "Flock test failed.\n";
+		failed = true;
+	}
+
+	if(steering_world(argc, argv)) {
+		std::cerr << "Vehicle world test failed.\n";
+		failed = true;
+	}
+
+	if(entitystore_update(argc, argv)) {
+		std::cerr << "Entity store test failed.\n";
+		failed = true;
+	}
+
+	if(math_vectormath(argc, argv)) {
+		std::cerr << "Vector math test failed.\n";
+		failed = true;
+	}
+
 	return failed ? 1 : 0;
 }